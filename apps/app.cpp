@@ -23,6 +23,7 @@
 #include "lcs/config.hpp"
 #include "lcs/logger.hpp"
 #include "lcs/stats.hpp"
+#include "lcs/trace.hpp"
 #include "mdns/mdns.hpp"
 #include "rtsp/rtsp.hpp"
 
@@ -107,13 +108,16 @@ int App::main(int argc, char *argv[]) {
   config()->init();
 
   Logger::startup();
-  Stats::init(*io_ctx);
+  Stats::init();
+  Trace::init();
 
   signal_set_ignore.emplace(*io_ctx, SIGHUP);
   signal_set_shutdown.emplace(*io_ctx, SIGINT);
+  signal_set_trace.emplace(*io_ctx, SIGUSR1);
 
   signals_ignore();   // ignore certain signals
   signals_shutdown(); // catch certain signals for shutdown
+  signals_trace();    // dump frame trace on demand
 
   INFO_AUTO("{}\n", config()->banner_msg());
   INFO(Config::module_id, fn_id, "{}\n", config()->init_msg);
@@ -124,6 +128,7 @@ int App::main(int argc, char *argv[]) {
   io_ctx->run(); // start the app, returns when shutdown signal received
 
   INFO_AUTO("io_ctx stopped={}\n", io_ctx->stopped());
+  Stats::shutdown();
   Logger::shutdown();
 
   return 0;
@@ -173,9 +178,22 @@ void App::signals_shutdown() noexcept {
     }
 
     signal_set_ignore->cancel(); // cancel the remaining work
+    signal_set_trace->cancel();
 
     shared::config.reset();
   });
 }
 
+void App::signals_trace() noexcept {
+  static constexpr csv fn_id{"sig_trace"};
+
+  signal_set_trace->async_wait([this](const error_code ec, int signal) {
+    if (!ec) {
+      signals_trace();
+
+      INFO_AUTO("caught SIGUSR1 ({}) trace {}\n", signal, Trace::dump());
+    }
+  });
+}
+
 } // namespace pierre
@@ -0,0 +1,94 @@
+//  Pierre - Custom Light Show for Wiss Landing
+//  Copyright (C) 2022  Tim Hughey
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//  https://www.wisslanding.com
+
+// anchor: Anchor::get_data() and ClockFilter with the master clock samples of
+// a scripted clock (sim::ClockScript) that drifts then changes master
+
+#include "bench.hpp"
+#include "frame/anchor.hpp"
+#include "frame/anchor_data.hpp"
+#include "frame/clock_filter.hpp"
+#include "sim/clock_script.hpp"
+
+#include <vector>
+
+namespace pierre {
+namespace bench {
+
+namespace {
+constexpr ClockID NEW_MASTER{0x2f4a9c0b11d20002};
+constexpr Nanos SCRIPT_DURATION{Seconds(60)};
+constexpr Nanos CLOCK_CHANGE_AT{Seconds(30)};
+
+/// @brief ClockInfo as published every interval of the script
+std::vector<ClockInfo> clock_infos(const sim::ClockScript &script, Nanos from, Nanos to) {
+  const auto start = pet::now_monotonic();
+  std::vector<ClockInfo> infos;
+
+  for (auto at = from; at < to; at += script.interval()) {
+    infos.emplace_back(script.clock_info(at, start));
+  }
+
+  return infos;
+}
+} // namespace
+
+void anchor(Runner &runner) {
+  Anchor::init();
+
+  sim::ClockScript script;
+
+  sim::clock_event drift;
+  drift.drift_ppm = 25.0;
+  drift.offset = 1'500'000'000;
+  script.add(drift);
+
+  sim::clock_event change;
+  change.at = CLOCK_CHANGE_AT;
+  change.clock_id = NEW_MASTER;
+  change.step = 40'000;
+  script.add(change);
+
+  // sender anchor (rtp time zero at one second of master clock time)
+  Anchor::save(AnchorData(sim::ClockScript::CLOCK_ID, 1, 0, 0, 0));
+
+  const auto stable = clock_infos(script, Nanos::zero(), CLOCK_CHANGE_AT);
+  const auto changed = clock_infos(script, CLOCK_CHANGE_AT, SCRIPT_DURATION);
+
+  runner.run("anchor.get_data", 0,
+             [&](size_t i) { keep(Anchor::get_data(stable[i % stable.size()])); });
+
+  // anchor remains on the previous master clock (not yet stable)
+  runner.run("anchor.get_data_new_master", 0,
+             [&](size_t i) { keep(Anchor::get_data(changed[i % changed.size()])); });
+
+  Anchor::reset();
+
+  // a new sample (and fit) per op, sample time must always advance
+  ClockFilter filter;
+  const auto start = pet::now_monotonic();
+  size_t n{0};
+
+  runner.run("anchor.clock_filter", 0, [&](size_t) {
+    filter.add(script.clock_info(script.interval() * n++, start));
+    keep(filter.offset_at());
+  });
+}
+
+} // namespace bench
+} // namespace pierre
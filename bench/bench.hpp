@@ -0,0 +1,131 @@
+//  Pierre - Custom Light Show for Wiss Landing
+//  Copyright (C) 2022  Tim Hughey
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//  https://www.wisslanding.com
+
+#pragma once
+
+#include "base/pet.hpp"
+#include "base/types.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace pierre {
+namespace bench {
+
+/// @brief Keep the compiler from discarding a value (or the work that produced it)
+template <typename T> inline void keep(T &&v) noexcept { asm volatile("" : : "g"(&v) : "memory"); }
+
+struct options {
+  string filter;             // run only benchmarks whose name contains filter
+  Millis min_time{500};      // minimum measured time per benchmark
+  size_t samples{10};        // timed batches per benchmark
+  size_t max_ops{1'000'000}; // upper bound on ops per batch
+  bool list{false};          // list names, do not run
+};
+
+struct result {
+  string name;
+  size_t ops{0};   // ops per sample (batch)
+  size_t bytes{0}; // bytes processed per op (zero when not meaningful)
+
+  // nanoseconds per op across the samples
+  double min{0};
+  double median{0};
+  double mean{0};
+  double max{0};
+  double stddev{0};
+};
+
+/// @brief Runs micro benchmarks and collects the results.  An op is timed in
+///        batches: the batch size is doubled until a batch takes at least
+///        min_time / samples then samples batches are timed.  The optional
+///        prepare is called (untimed) before each batch with the batch size
+///        so ops that consume their input (e.g. decipher in place) can be
+///        given fresh input.
+class Runner {
+public:
+  Runner(options opts) noexcept : opts(std::move(opts)) {}
+
+  template <typename Op> void run(csv name, size_t bytes, Op &&op) {
+    run(name, bytes, std::forward<Op>(op), [](size_t) {});
+  }
+
+  template <typename Op, typename Prepare>
+  void run(csv name, size_t bytes, Op &&op, Prepare &&prepare) {
+    if (!wanted(name)) return;
+
+    const auto batch = [&](size_t n) {
+      prepare(n);
+
+      const auto start = std::chrono::steady_clock::now();
+      for (size_t i = 0; i < n; i++) {
+        op(i);
+      }
+
+      return std::chrono::steady_clock::now() - start;
+    };
+
+    // calibrate the batch size (also warms caches, branch predictors, pools)
+    const auto target = opts.min_time / opts.samples;
+    size_t n{1};
+
+    while ((batch(n) < target) && (n < opts.max_ops)) {
+      n *= 2;
+    }
+
+    std::vector<double> ns_per_op;
+    for (size_t s = 0; s < opts.samples; s++) {
+      ns_per_op.push_back(std::chrono::duration<double, std::nano>(batch(n)).count() / n);
+    }
+
+    record(name, n, bytes, std::move(ns_per_op));
+  }
+
+  /// @brief Host, build and results as a JSON document (see pierre_bench.cpp)
+  const string json() const noexcept;
+
+  const auto &results() const noexcept { return all; }
+
+  /// @brief Benchmark matches the filter (when listing prints the name instead)
+  bool wanted(csv name) const noexcept;
+
+private:
+  void record(csv name, size_t ops, size_t bytes, std::vector<double> &&ns_per_op) noexcept;
+
+private:
+  // order dependent
+  const options opts;
+
+  // order independent
+  std::vector<result> all;
+
+public:
+  static constexpr csv module_id{"bench.runner"};
+};
+
+// benchmark suites (one per translation unit)
+void anchor(Runner &runner);
+void desk(Runner &runner);
+void dsp(Runner &runner);
+void frame(Runner &runner);
+void rtsp(Runner &runner);
+
+} // namespace bench
+} // namespace pierre
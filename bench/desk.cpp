@@ -0,0 +1,100 @@
+//  Pierre - Custom Light Show for Wiss Landing
+//  Copyright (C) 2022  Tim Hughey
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//  https://www.wisslanding.com
+
+// desk: Hsb::toRgb(), Color::interpolate(), fader::ToBlack travel and the
+// per frame DmxDataMsg (Units::update_msg() then msgpack serialization)
+
+#include "base/input_info.hpp"
+#include "bench.hpp"
+#include "desk/color.hpp"
+#include "desk/dmx_data_msg.hpp"
+#include "desk/unit/all.hpp"
+#include "desk/units.hpp"
+#include "fader/easings.hpp"
+#include "fader/toblack.hpp"
+#include "frame/silent_frame.hpp"
+
+#include <array>
+#include <cstdint>
+
+namespace pierre {
+namespace bench {
+
+namespace {
+using Fader = fader::ToBlack<fader::SimpleLinear>;
+
+// long enough that a fader never finishes during a benchmark
+constexpr Nanos FADE_DURATION{Minutes(60)};
+} // namespace
+
+void desk(Runner &runner) {
+  // around the color wheel at a few brightness levels
+  std::array<Hsb, 360> hsbs;
+  for (size_t i = 0; i < hsbs.size(); i++) {
+    hsbs[i] = Hsb{.hue = i / 360.0, .sat = 1.0, .bri = ((i % 4) + 1) / 4.0};
+  }
+
+  runner.run("color.hsb_to_rgb", 0, [&](size_t i) {
+    uint8_t red, grn, blu;
+
+    hsbs[i % hsbs.size()].toRgb(red, grn, blu);
+    keep(red);
+    keep(grn);
+    keep(blu);
+  });
+
+  const Color origin(Hsb{.hue = 0.10, .sat = 1.0, .bri = 1.0});
+  const Color dest(Hsb{.hue = 0.65, .sat = 0.8, .bri = 0.5});
+
+  runner.run("color.interpolate", 0, [&](size_t i) {
+    auto color = Color::interpolate(origin, dest, (i % 1024) / 1024.0);
+    keep(color);
+  });
+
+  Fader to_black({.origin = origin, .duration = FADE_DURATION});
+
+  runner.run("fader.to_black_travel", 0, [&](size_t) { keep(to_black.travel()); });
+
+  // the units and DmxDataMsg as rendered for every frame, both pinspots are
+  // fading so prepare() includes fader travel
+  Units units;
+  units.create_all_from_cfg();
+
+  for (const auto &name : {unit_name::MAIN_SPOT, unit_name::FILL_SPOT}) {
+    units.get<PinSpot>(name)->activate<Fader>({.origin = origin, .duration = FADE_DURATION});
+  }
+
+  auto frame = SilentFrame::create();
+  DmxDataMsg msg(frame, InputInfo::lead_time);
+
+  runner.run("desk.units_update_msg", 0, [&](size_t) {
+    units.prepare();
+    units.update_msg(msg);
+  });
+
+  runner.run("desk.dmx_data_msg", 0, [&](size_t) {
+    DmxDataMsg msg(frame, InputInfo::lead_time);
+
+    units.update_msg(msg);
+    msg.serialize();
+    keep(msg.packed_len);
+  });
+}
+
+} // namespace bench
+} // namespace pierre
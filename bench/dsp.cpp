@@ -0,0 +1,111 @@
+//  Pierre - Custom Light Show for Wiss Landing
+//  Copyright (C) 2022  Tim Hughey
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//  https://www.wisslanding.com
+
+// dsp: FFT::process() (per channel and joint stereo), FFT::find_peaks() and
+// Peaks::select()
+
+#include "bench.hpp"
+#include "frame/fft.hpp"
+#include "frame/peaks.hpp"
+
+#include <array>
+#include <cmath>
+#include <numbers>
+#include <random>
+
+namespace pierre {
+namespace bench {
+
+namespace {
+constexpr float SAMPLE_RATE{44100.0f};
+
+/// @brief One channel of audio: bass, mid and treble tones plus a little
+///        (deterministic) noise, scaled like decoded AAC
+std::array<float, FFT::SAMPLES> tones(float phase) noexcept {
+  constexpr auto two_pi = 2.0f * std::numbers::pi_v<float>;
+
+  std::mt19937 gen(1);
+  std::uniform_real_distribution<float> noise(-0.01f, 0.01f);
+  std::array<float, FFT::SAMPLES> samples;
+
+  for (size_t i = 0; i < samples.size(); i++) {
+    const float t = i / SAMPLE_RATE;
+
+    samples[i] = (0.30f * std::sin(two_pi * 60.0f * t + phase)) +   // bass
+                 (0.20f * std::sin(two_pi * 440.0f * t + phase)) +  // mid
+                 (0.10f * std::sin(two_pi * 3500.0f * t + phase)) + // treble
+                 noise(gen);
+  }
+
+  return samples;
+}
+} // namespace
+
+void dsp(Runner &runner) {
+  constexpr size_t fft_bytes{FFT::SAMPLES * sizeof(float)};
+
+  const auto left = tones(0.0f);
+  const auto right = tones(0.5f);
+  const FFT fft_left(left.data(), left.size(), SAMPLE_RATE);
+  const FFT fft_right(right.data(), right.size(), SAMPLE_RATE);
+
+  // process() transforms in place so each op starts from a copy (4KiB)
+  runner.run("fft.process", fft_bytes, [&](size_t) {
+    FFT fft(fft_left);
+    fft.process();
+    keep(fft);
+  });
+
+  runner.run("fft.process_joint", fft_bytes * 2, [&](size_t) {
+    FFT l(fft_left);
+    FFT r(fft_right);
+
+    FFT::process(l, r);
+    keep(l);
+    keep(r);
+  });
+
+  FFT processed(fft_left);
+  processed.process();
+
+  runner.run("fft.find_peaks", 0, [&](size_t) {
+    Peaks peaks;
+    processed.find_peaks(peaks, Peaks::LEFT);
+    keep(peaks);
+  });
+
+  // candidates as find_peaks() presents them (local maxima in frequency order)
+  std::array<float, FFT::SAMPLES / 4> mags;
+  std::array<float, FFT::SAMPLES / 4> freqs;
+  std::mt19937 gen(1);
+  std::uniform_real_distribution<float> mag(0.5f, 40.0f);
+
+  for (size_t i = 0; i < mags.size(); i++) {
+    mags[i] = mag(gen);
+    freqs[i] = (i * 2 + 1) * (SAMPLE_RATE / FFT::SAMPLES);
+  }
+
+  runner.run("peaks.select", 0, [&](size_t) {
+    Peaks peaks;
+    peaks.select(Peaks::LEFT, mags, freqs);
+    keep(peaks);
+  });
+}
+
+} // namespace bench
+} // namespace pierre
@@ -0,0 +1,244 @@
+//  Pierre - Custom Light Show for Wiss Landing
+//  Copyright (C) 2022  Tim Hughey
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//  https://www.wisslanding.com
+
+// frame: Frame::decipher() and Av::parse() (decode then hand off to dsp)
+//
+// the audio payloads are AAC LC (44.1kHz, stereo, 1024 samples per frame) as
+// sent by AirPlay, encoded at startup by the libav AAC encoder from a mix of
+// tones then ciphered exactly as the sender does (ChaCha20-Poly1305, detached
+// tag followed by the eight byte nonce)
+
+#include "base/uint8v.hpp"
+#include "bench.hpp"
+#include "frame/av.hpp"
+#include "frame/frame.hpp"
+#include "io/io.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <fmt/format.h>
+#include <memory>
+#include <numbers>
+#include <random>
+#include <sodium.h>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace pierre {
+namespace bench {
+
+namespace {
+constexpr int SAMPLE_RATE{44100};
+constexpr size_t PAYLOADS{64};
+
+// packet layout (see frame.cpp): RTP header, ciphered audio, tag, nonce
+constexpr size_t RTP_HEADER_BYTES{12};
+constexpr size_t TAG_BYTES{crypto_aead_chacha20poly1305_ietf_ABYTES};
+constexpr size_t NONCE_MINI_BYTES{8};
+
+/// @brief AAC frames encoded from a mix of tones (empty if no encoder)
+std::vector<uint8v> aac_payloads(size_t count) noexcept {
+  constexpr auto two_pi = 2.0f * std::numbers::pi_v<float>;
+  std::vector<uint8v> payloads;
+
+  const auto *codec = avcodec_find_encoder(AV_CODEC_ID_AAC);
+  if (!codec) return payloads;
+
+  auto *ctx = avcodec_alloc_context3(codec);
+  ctx->sample_rate = SAMPLE_RATE;
+  ctx->channel_layout = AV_CH_LAYOUT_STEREO;
+  ctx->channels = 2;
+  ctx->sample_fmt = AV_SAMPLE_FMT_FLTP;
+  ctx->bit_rate = 256'000;
+  ctx->profile = FF_PROFILE_AAC_LOW;
+
+  auto *audio = av_frame_alloc();
+  auto *pkt = av_packet_alloc();
+
+  if ((avcodec_open2(ctx, codec, nullptr) == 0) && audio && pkt) {
+    audio->nb_samples = ctx->frame_size;
+    audio->format = ctx->sample_fmt;
+    audio->channel_layout = ctx->channel_layout;
+
+    for (int64_t t = 0; (payloads.size() < count) && (av_frame_get_buffer(audio, 0) == 0);) {
+      for (auto ch = 0; ch < 2; ch++) {
+        auto *plane = reinterpret_cast<float *>(audio->data[ch]);
+
+        for (auto i = 0; i < audio->nb_samples; i++) {
+          const float s = static_cast<float>(t + i) / SAMPLE_RATE;
+
+          plane[i] = (0.30f * std::sin(two_pi * 60.0f * s)) +       // bass
+                     (0.20f * std::sin(two_pi * 440.0f * s + ch)) + // mid
+                     (0.10f * std::sin(two_pi * 3500.0f * s));      // treble
+        }
+      }
+
+      audio->pts = t;
+      t += audio->nb_samples;
+
+      if (avcodec_send_frame(ctx, audio) < 0) break;
+
+      while (avcodec_receive_packet(ctx, pkt) == 0) {
+        payloads.emplace_back().assign(pkt->data, pkt->data + pkt->size);
+        av_packet_unref(pkt);
+      }
+
+      av_frame_unref(audio); // the encoder may hold a reference, get a new buffer
+      audio->nb_samples = ctx->frame_size;
+      audio->format = ctx->sample_fmt;
+      audio->channel_layout = ctx->channel_layout;
+    }
+  }
+
+  av_packet_free(&pkt);
+  av_frame_free(&audio);
+  avcodec_free_context(&ctx);
+
+  return payloads;
+}
+
+/// @brief RTP packet with the payload ciphered as the sender does
+uint8v ciphered_packet(const uint8v &payload, uint32_t seq_num, const uint8v &key) noexcept {
+  uint8v packet(RTP_HEADER_BYTES + payload.size() + TAG_BYTES + NONCE_MINI_BYTES, 0x00);
+
+  packet[0] = 0x80; // RTPv2
+
+  // sequence number is three bytes (see Frame)
+  for (auto i = 0; i < 3; i++) {
+    packet[1 + i] = (seq_num >> (16 - (i * 8))) & 0xff;
+  }
+
+  const uint32_t timestamp = seq_num * 1024;
+  for (auto i = 0; i < 4; i++) {
+    packet[4 + i] = (timestamp >> (24 - (i * 8))) & 0xff;
+  }
+
+  // the sender only provides eight bytes of nonce, libsodium wants twelve
+  auto *nonce_mini = packet.data() + packet.size() - NONCE_MINI_BYTES;
+  for (size_t i = 0; i < NONCE_MINI_BYTES; i++) {
+    nonce_mini[i] = (seq_num >> ((i % 4) * 8)) & 0xff;
+  }
+
+  std::array<uint8_t, crypto_aead_chacha20poly1305_ietf_NPUBBYTES> nonce{0};
+  std::copy_n(nonce_mini, NONCE_MINI_BYTES, nonce.end() - NONCE_MINI_BYTES);
+
+  crypto_aead_chacha20poly1305_ietf_encrypt_detached( //
+      packet.data() + RTP_HEADER_BYTES,                 // ciphered
+      nonce_mini - TAG_BYTES,                           // detached tag
+      nullptr,                                          // tag length (always ABYTES)
+      payload.data(),                                   // clear text
+      payload.size(),                                   // clear text length
+      packet.data() + 4,                                // aad (timestamp and ssrc)
+      8,                                                // aad length
+      nullptr,                                          // nsec (unused, must be nullptr)
+      nonce.data(),                                     // the nonce
+      key.data());                                      // shared key
+
+  return packet;
+}
+
+} // namespace
+
+void frame(Runner &runner) {
+  if (sodium_init() < 0) throw std::runtime_error("sodium_init() failed");
+
+  const auto payloads = aac_payloads(PAYLOADS);
+
+  if (payloads.empty()) {
+    fmt::print(stderr, "frame: no AAC encoder, skipping frame benchmarks\n");
+    return;
+  }
+
+  size_t payload_bytes{0};
+  for (const auto &p : payloads) {
+    payload_bytes += p.size();
+  }
+
+  payload_bytes /= payloads.size();
+
+  std::mt19937 gen(1);
+  uint8v key(crypto_aead_chacha20poly1305_ietf_KEYBYTES, 0x00);
+  std::generate(key.begin(), key.end(), [&gen]() { return gen() & 0xff; });
+
+  std::vector<uint8v> packets;
+  for (uint32_t seq_num = 0; const auto &p : payloads) {
+    packets.emplace_back(ciphered_packet(p, seq_num++, key));
+  }
+
+  // each batch deciphers (in place) fresh copies of the packets
+  std::vector<uint8v> wire;
+  std::vector<frame_t> frames;
+
+  auto ciphered = [&](size_t n) {
+    frames.clear();
+    wire.clear();
+
+    for (size_t i = 0; i < n; i++) {
+      auto &packet = wire.emplace_back(packets[i % packets.size()]);
+      frames.emplace_back(Frame::create(packet));
+    }
+  };
+
+  ciphered(1);
+  if (!frames[0]->decipher(std::move(wire[0]), key)) {
+    throw std::runtime_error("decipher failed: " + frames[0]->inspect());
+  }
+
+  runner.run(
+      "frame.decipher", payload_bytes,
+      [&](size_t i) { keep(frames[i]->decipher(std::move(wire[i]), key)); }, ciphered);
+
+  // Av finishes setup on the io_ctx, decoded frames are processed by the dsp
+  // threads (in the background) so wait for them to release the previous batch
+  io_context io_ctx;
+  auto av = std::make_unique<Av>(io_ctx);
+  io_ctx.run();
+
+  auto deciphered = [&](size_t n) {
+    for (const auto &f : frames) {
+      while (f.use_count() > 1) std::this_thread::yield();
+    }
+
+    ciphered(n);
+
+    for (size_t i = 0; i < n; i++) {
+      frames[i]->decipher(std::move(wire[i]), key);
+    }
+  };
+
+  // the first few frames prime the decoder
+  deciphered(PAYLOADS);
+  for (auto &f : frames) {
+    av->parse(f);
+  }
+
+  if (!frames.back()->state.dsp_any()) {
+    throw std::runtime_error("decode failed: " + frames.back()->inspect());
+  }
+
+  runner.run(
+      "av.parse", payload_bytes, [&](size_t i) { keep(av->parse(frames[i])); }, deciphered);
+
+  deciphered(0); // wait for dsp
+  av.reset();
+}
+
+} // namespace bench
+} // namespace pierre
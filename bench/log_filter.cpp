@@ -0,0 +1,131 @@
+//  Pierre - Custom Light Show for Wiss Landing
+//  Copyright (C) 2022  Tim Hughey
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//  https://www.wisslanding.com
+
+// micro benchmark: Logger::should_log() as a toml path walk (Config::info_bool)
+// versus the compiled LogFilter
+
+#include "base/types.hpp"
+#include "lcs/config.hpp"
+#include "lcs/log_filter.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <fmt/format.h>
+#include <utility>
+
+using namespace pierre;
+
+namespace {
+
+constexpr auto info_toml = R"(
+[info]
+init = true
+threads = true
+debug = false
+frames = { av = false, flush = false, racked = false }
+
+[info.frame]
+dsp = { thread = false }
+
+[info.master_clock]
+init = true
+shutdown = false
+peers_update = false
+thread = false
+
+[info.mdns]
+ctx = { browse = false, cb_client = true, cb_browse = false, resolved = false }
+
+[info.rtsp]
+audio = false
+ctx = true
+event = false
+reply = { build = false }
+request = true
+session = true
+)"sv;
+
+// a mix of categories that hit each level of precedence (and miss)
+constexpr std::array<std::pair<csv, csv>, 8> lookups{{{"frame.racked"sv, "thread"sv},
+                                                      {"master_clock"sv, "init"sv},
+                                                      {"master_clock"sv, "peers_update"sv},
+                                                      {"mdns.ctx"sv, "cb_client"sv},
+                                                      {"rtsp.reply"sv, "build"sv},
+                                                      {"rtsp"sv, "session"sv},
+                                                      {"desk"sv, "frame_loop"sv},
+                                                      {"frame.dsp"sv, "thread"sv}}};
+
+// identical to Config::info_bool() minus the shared lock
+bool toml_walk(const toml::table &live, csv mod, csv cat) noexcept {
+  if (cat == csv{"info"}) return true;
+
+  auto path = toml::path("info"sv);
+
+  if (live[toml::path(path).append(cat)].is_boolean()) {
+    return live[path.append(cat)].ref<bool>();
+  } else if (live[toml::path(path).append(mod)].is_boolean()) {
+    return live[path.append(mod)].ref<bool>();
+  } else {
+    return live[path.append(mod).append(cat)].value_or(true);
+  }
+}
+
+template <typename F> double ns_per_call(size_t loops, F &&f) noexcept {
+  size_t hits{0};
+  const auto start = std::chrono::steady_clock::now();
+
+  for (size_t i = 0; i < loops; i++) {
+    const auto &[mod, cat] = lookups[i % lookups.size()];
+    hits += f(mod, cat);
+  }
+
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+
+  if (hits == loops + 1) std::abort(); // keep the loop from being optimized away
+
+  return std::chrono::duration<double, std::nano>(elapsed).count() / loops;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  const size_t loops = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1'000'000;
+
+  const auto live = toml::parse(info_toml);
+  const LogFilter filter(*live["info"sv].as_table());
+
+  // both must agree before the timings mean anything
+  for (const auto &[mod, cat] : lookups) {
+    if (toml_walk(live, mod, cat) != filter.should_log(mod, cat)) {
+      fmt::print("MISMATCH mod={} cat={}\n", mod, cat);
+      return 1;
+    }
+  }
+
+  const auto walk = ns_per_call(loops, [&](csv mod, csv cat) { return toml_walk(live, mod, cat); });
+  const auto compiled = ns_per_call(loops, [&](csv mod, csv cat) {
+    return filter.should_log(mod, cat); //
+  });
+
+  fmt::print("should_log loops={} entries={}\n", loops, filter.size());
+  fmt::print("  toml walk  {:>8.1f} ns/call\n", walk);
+  fmt::print("  LogFilter  {:>8.1f} ns/call\n", compiled);
+
+  return 0;
+}
@@ -0,0 +1,159 @@
+//  Pierre - Custom Light Show for Wiss Landing
+//  Copyright (C) 2022  Tim Hughey
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//  https://www.wisslanding.com
+
+// micro benchmarks of the per frame hot paths (anchor, dsp, frame, desk, rtsp)
+//
+// usage: pierre_bench [--filter=<substr>] [--min-ms=<ms>] [--samples=<n>]
+//                     [--max-ops=<n>] [--out=<file>] [--list]
+//
+// results are written as JSON (stdout or --out) for comparison across commits
+// and hosts, a human readable summary is written to stderr.  every host runs
+// with the same embedded config so results are comparable.
+
+#include "bench.hpp"
+#include "io/io.hpp"
+#include "lcs/config.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <fmt/format.h>
+#include <fmt/os.h>
+#include <memory>
+
+using namespace pierre;
+
+namespace {
+namespace fs = std::filesystem;
+
+constexpr auto bench_toml = R"(
+[base]
+config_vsn = "bench"
+
+[frame.dsp]
+concurrency_factor = 0.4
+joint_stereo = false
+
+[frame.peaks.magnitudes]
+floor = 2.1
+ceiling = 32.0
+
+[desk.dimmable]
+max = 8190
+units = [
+  { name = "el dance", addr = 2, max = 0.25, min = 0.01, dim = 0.03 },
+  { name = "el entry", addr = 3, max = 0.25, min = 0.01, dim = 0.03 },
+  { name = "led forest", addr = 4, dim = 0.005, pulse = { start = 0.02, end = 0.005 } },
+  { name = "disco ball", addr = 1, dim = 0.65, pulse = { start = 0.65, end = 0.85 } },
+]
+
+[desk.pinspot]
+units = [
+  { name = "main pinspot", addr = 1, frame_len = 6 },
+  { name = "fill pinspot", addr = 7, frame_len = 6 },
+]
+
+[desk.switch]
+units = [{ name = "ac power", addr = 1 }]
+)"sv;
+
+// Config reads <home>/.pierre/<cfg-file>, give it a private home
+toml::table bench_cli_table() {
+  const auto home = fs::temp_directory_path() / "pierre-bench";
+  const auto dir = home / ".pierre";
+
+  fs::create_directories(dir);
+
+  auto out = fmt::output_file((dir / "bench.toml").string());
+  out.print("{}", bench_toml);
+  out.close();
+
+  toml::table cli_table;
+  cli_table.emplace("home"sv, home.string());
+  cli_table.emplace("cfg-file"sv, string("bench.toml"));
+  cli_table.emplace("app_name"sv, string("pierre_bench"));
+
+  return cli_table;
+}
+
+bench::options parse_args(int argc, char *argv[], string &out_path) {
+  bench::options opts;
+
+  for (int i = 1; i < argc; i++) {
+    const csv arg{argv[i]};
+    const auto val = [&arg](csv key) { return arg.substr(key.size()); };
+    const auto num = [&](csv key) { return std::strtoull(val(key).data(), nullptr, 10); };
+
+    if (arg.starts_with("--filter=")) {
+      opts.filter = val("--filter=");
+    } else if (arg.starts_with("--min-ms=")) {
+      opts.min_time = Millis(num("--min-ms="));
+    } else if (arg.starts_with("--samples=")) {
+      opts.samples = std::max(num("--samples="), 1ULL);
+    } else if (arg.starts_with("--max-ops=")) {
+      opts.max_ops = std::max(num("--max-ops="), 1ULL);
+    } else if (arg.starts_with("--out=")) {
+      out_path = val("--out=");
+    } else if (arg == "--list") {
+      opts.list = true;
+    } else {
+      fmt::print(stderr, "unknown argument: {}\n", arg);
+      std::exit(1);
+    }
+  }
+
+  return opts;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  string out_path;
+  const auto opts = parse_args(argc, argv, out_path);
+
+  io_context io_ctx;
+  shared::config = std::make_unique<Config>(io_ctx, bench_cli_table());
+  config()->init();
+
+  bench::Runner runner(opts);
+
+  try {
+    bench::anchor(runner);
+    bench::dsp(runner);
+    bench::frame(runner);
+    bench::desk(runner);
+    bench::rtsp(runner);
+  } catch (const std::exception &e) {
+    fmt::print(stderr, "benchmark failed: {}\n", e.what());
+    return 1;
+  }
+
+  if (!opts.list) {
+    if (out_path.empty()) {
+      fmt::print("{}", runner.json());
+    } else {
+      auto out = fmt::output_file(out_path);
+      out.print("{}", runner.json());
+    }
+  }
+
+  shared::config.reset();
+
+  return 0;
+}
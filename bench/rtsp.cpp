@@ -0,0 +1,109 @@
+//  Pierre - Custom Light Show for Wiss Landing
+//  Copyright (C) 2022  Tim Hughey
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//  https://www.wisslanding.com
+
+// rtsp: Headers::parse() and Aes::decrypt() of a typical request
+
+#include "base/uint8v.hpp"
+#include "bench.hpp"
+#include "pair/pair.h"
+#include "rtsp/aes.hpp"
+#include "rtsp/headers.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+namespace pierre {
+namespace bench {
+
+namespace {
+// as captured (see extra/ref/headers.txt) including the 37 byte body
+constexpr auto request{"POST /pair-verify RTSP/1.0\r\n"
+                       "Active-Remote: 72068767\r\n"
+                       "CSeq: 1\r\n"
+                       "Content-Length: 37\r\n"
+                       "Content-Type: application/octet-stream\r\n"
+                       "DACP-ID: 6E2DB4E8B3489D27\r\n"
+                       "User-Agent: AirPlay/665.13.1\r\n"
+                       "X-Apple-Client-Name: xapham\r\n"
+                       "X-Apple-HKP: 6\r\n"
+                       "X-Apple-PD: 1\r\n"
+                       "\r\n"
+                       "0123456789abcdef0123456789abcdef01234"sv};
+} // namespace
+
+void rtsp(Runner &runner) {
+  uint8v packet;
+  packet.assign(request.begin(), request.end());
+
+  const std::array<csv, 2> delims_want{"\r\n"sv, "\r\n\r\n"sv};
+  const auto delims = packet.find_delims(delims_want);
+
+  runner.run("rtsp.headers_parse", packet.size(), [&](size_t) {
+    Headers headers;
+    keep(headers.parse(packet, delims));
+  });
+
+  // the sender side of the cipher (controller writes what we read)
+  std::mt19937 gen(1);
+  uint8v secret(64, 0x00);
+  std::generate(secret.begin(), secret.end(), [&gen]() { return gen() & 0xff; });
+
+  rtsp::Aes aes(secret);
+  auto *sender = pair_cipher_new(PAIR_CLIENT_HOMEKIT_NORMAL, 0, secret.data(), secret.size());
+  if (sender == nullptr) throw std::runtime_error("pair_cipher_new() failed");
+
+  // the cipher nonce advances with each message so each batch is given
+  // freshly ciphered messages (in order)
+  std::vector<uint8v> wire;
+
+  auto ciphered = [&](size_t n) {
+    wire.clear();
+
+    for (size_t i = 0; i < n; i++) {
+      uint8_t *data{nullptr};
+      size_t len{0};
+
+      pair_encrypt(&data, &len, packet.data(), packet.size(), sender);
+      wire.emplace_back().assign(data, data + len);
+      std::free(data);
+    }
+  };
+
+  ciphered(1);
+  if (uint8v clear; (aes.decrypt(wire[0], clear) <= 0) || (clear != packet)) {
+    pair_cipher_free(sender);
+    throw std::runtime_error("decrypt failed");
+  }
+
+  runner.run(
+      "rtsp.aes_decrypt", packet.size(),
+      [&](size_t i) {
+        uint8v clear;
+        keep(aes.decrypt(wire[i], clear));
+      },
+      ciphered);
+
+  pair_cipher_free(sender);
+}
+
+} // namespace bench
+} // namespace pierre
@@ -0,0 +1,127 @@
+//  Pierre - Custom Light Show for Wiss Landing
+//  Copyright (C) 2022  Tim Hughey
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//  https://www.wisslanding.com
+
+#include "bench.hpp"
+#include "build_version.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <fmt/format.h>
+#include <iterator>
+#include <numeric>
+#include <sys/utsname.h>
+#include <thread>
+
+namespace pierre {
+namespace bench {
+
+namespace {
+#ifdef NDEBUG
+constexpr bool ndebug{true};
+#else
+constexpr bool ndebug{false};
+#endif
+
+// quote and escape a string for JSON (names, host and compiler info only)
+string quoted(csv s) noexcept {
+  string out{"\""};
+
+  for (const auto c : s) {
+    if ((c == '"') || (c == '\\')) out.push_back('\\');
+    if (static_cast<unsigned char>(c) >= 0x20) out.push_back(c);
+  }
+
+  out.push_back('"');
+
+  return out;
+}
+} // namespace
+
+const string Runner::json() const noexcept {
+  struct utsname uts {};
+  uname(&uts);
+
+  string msg;
+  auto w = std::back_inserter(msg);
+
+  fmt::format_to(w, "{{\n");
+  fmt::format_to(w, "  \"schema\": 1,\n");
+  fmt::format_to(w,
+                 "  \"build\": {{\"vsn\": {}, \"time\": {}, \"compiler\": {}, \"ndebug\": {}}},\n",
+                 quoted(build::vsn), quoted(build::timestamp), quoted(__VERSION__), ndebug);
+
+  fmt::format_to(w,
+                 "  \"host\": {{\"name\": {}, \"machine\": {}, \"system\": {}, \"release\": {}, "
+                 "\"cpus\": {}}},\n",
+                 quoted(uts.nodename), quoted(uts.machine), quoted(uts.sysname),
+                 quoted(uts.release), std::thread::hardware_concurrency());
+
+  fmt::format_to(w, "  \"options\": {{\"min_time_ms\": {}, \"samples\": {}, \"filter\": {}}},\n",
+                 opts.min_time.count(), opts.samples, quoted(opts.filter));
+
+  fmt::format_to(w, "  \"results\": [");
+
+  for (auto it = all.begin(); it != all.end(); ++it) {
+    const auto &r = *it;
+
+    fmt::format_to(w, "{}\n    {{\"name\": {}, \"ops\": {}, \"bytes\": {}, ", //
+                   it == all.begin() ? "" : ",", quoted(r.name), r.ops, r.bytes);
+    fmt::format_to(w,
+                   "\"ns_per_op\": {{\"min\": {:.2f}, \"median\": {:.2f}, \"mean\": {:.2f}, "
+                   "\"max\": {:.2f}, \"stddev\": {:.2f}}}}}",
+                   r.min, r.median, r.mean, r.max, r.stddev);
+  }
+
+  fmt::format_to(w, "\n  ]\n}}\n");
+
+  return msg;
+}
+
+void Runner::record(csv name, size_t ops, size_t bytes, std::vector<double> &&ns) noexcept {
+  std::sort(ns.begin(), ns.end());
+
+  auto &r = all.emplace_back(result{.name = string(name), .ops = ops, .bytes = bytes});
+
+  const auto n = std::ssize(ns);
+  r.min = ns.front();
+  r.max = ns.back();
+  r.median = (n % 2) ? ns[n / 2] : (ns[n / 2 - 1] + ns[n / 2]) / 2.0;
+  r.mean = std::accumulate(ns.begin(), ns.end(), 0.0) / n;
+
+  const auto sq_sum = std::accumulate(ns.begin(), ns.end(), 0.0, [&r](double acc, double v) {
+    return acc + ((v - r.mean) * (v - r.mean));
+  });
+
+  r.stddev = (n > 1) ? std::sqrt(sq_sum / (n - 1)) : 0.0;
+
+  // progress for humans (stdout is reserved for the JSON)
+  fmt::print(stderr, "{:<28} {:>12.1f} ns/op  (min {:.1f} max {:.1f}, {} ops x {})\n", r.name,
+             r.median, r.min, r.max, r.ops, n);
+}
+
+bool Runner::wanted(csv name) const noexcept {
+  if (opts.list) {
+    fmt::print("{}\n", name);
+    return false;
+  }
+
+  return opts.filter.empty() || name.find(opts.filter) != csv::npos;
+}
+
+} // namespace bench
+} // namespace pierre
@@ -35,12 +35,14 @@ public:
 private:
   void signals_ignore() noexcept;
   void signals_shutdown() noexcept;
+  void signals_trace() noexcept;
 
 private:
   // order dependent
   std::optional<io_context> io_ctx;
   std::optional<asio::signal_set> signal_set_ignore;
   std::optional<asio::signal_set> signal_set_shutdown;
+  std::optional<asio::signal_set> signal_set_trace;
   std::unique_ptr<Rtsp> rtsp;
 
   // order independent
@@ -19,14 +19,41 @@
 
 #pragma once
 
+#include "base/pet.hpp"
 #include "base/types.hpp"
 
+#include <cstddef>
 #include <thread>
 
 namespace pierre {
 
 struct thread_util {
+  /// @brief Full name given by set_name() (pthread names are limited to 15 chars)
+  static csv name() noexcept;
+
   static const string set_name(csv name, int num = -1) noexcept;
+
+  // real-time support, each returns zero or an errno value
+
+  /// @brief Pin the calling thread to a cpu
+  static int set_affinity(int cpu) noexcept;
+
+  /// @brief Run the calling thread SCHED_FIFO at priority
+  static int set_fifo(int priority) noexcept;
+
+  /// @brief Lock current and future pages of the process in memory
+  static int lock_memory() noexcept;
+
+  /// @brief Touch the calling thread's stack so page faults don't occur later
+  static void prefault_stack() noexcept;
+
+  /// @brief Sleep until an absolute time (clock_nanosleep TIMER_ABSTIME, so
+  ///        preemption after the deadline is translated does not add to the
+  ///        sleep; preemption while translating can only make the wake late)
+  /// @param deadline pet::now_monotonic() time to wake
+  static void sleep_until(Nanos deadline) noexcept;
+
+  static constexpr size_t STACK_PREFAULT{256 * 1024};
 };
 
 } // namespace pierre
@@ -44,7 +44,6 @@ using Thread = std::jthread;
 // Vector of Floats
 using reals_t = std::vector<double>;
 
-using reel_serial_num_t = uint64_t;
 using seq_num_t = uint32_t;   // frame sequence num
 using timestamp_t = uint32_t; // frame timestamp
 
@@ -30,6 +30,7 @@
 #include <memory>
 #include <mutex>
 #include <optional>
+#include <thread>
 
 namespace pierre {
 
@@ -44,6 +45,10 @@ public:
   Desk(MasterClock *master_clock) noexcept; // must be defined in .cpp to hide FX includes
   ~Desk() noexcept;
 
+  void audio_format(uint64_t ct) noexcept {
+    if (racked.has_value()) racked->audio_format(ct);
+  }
+
   void flush(FlushInfo &&request) noexcept {
     if (racked.has_value()) {
       racked->flush(std::forward<FlushInfo>(request));
@@ -54,8 +59,8 @@ public:
     if (racked.has_value()) racked->flush_all();
   }
 
-  void handoff(uint8v &&packet, const uint8v &key) noexcept {
-    if (racked.has_value()) racked->handoff(std::forward<uint8v>(packet), key);
+  void handoff(uint8v &&packet, std::shared_ptr<const uint8v> key) noexcept {
+    if (racked.has_value()) racked->handoff(std::forward<uint8v>(packet), std::move(key));
   }
 
   void resume() noexcept;
@@ -70,6 +75,10 @@ private:
   void frame_loop() noexcept;
   void frame_timer_cancel() noexcept;
 
+  /// @brief Dedicated render thread (desk.render.rt), applies the configured
+  ///        real-time settings then runs frame_loop()
+  void render_loop() noexcept;
+
 private:
   enum state_t : int { Running = 0, Stopped };
 
@@ -91,6 +100,11 @@ private:
   std::unique_ptr<DmxCtrl> dmx_ctrl{nullptr};
   std::unique_ptr<FX> active_fx{nullptr};
 
+  // frame_loop() runs on a dedicated thread waiting with absolute deadlines
+  // (otherwise on an io_ctx thread waiting with frame_timer)
+  bool render_rt{false};
+  std::jthread render_thread;
+
 public:
   static constexpr csv module_id{"desk"};
   static constexpr auto TASK_NAME{"desk"};
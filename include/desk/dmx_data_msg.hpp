@@ -33,9 +33,10 @@ class DmxDataMsg : public desk::Msg {
 
 public:
   DmxDataMsg(frame_t frame, const Nanos lead_time)
-      : Msg(TYPE),               // init base class
-        dmx_frame(16, 0x00),     // init the dmx frame to all zeros
-        silence(frame->silent()) // is this silence?
+      : Msg(TYPE),                // init base class
+        seq_num(frame->seq_num),  // for tracing the DMX write
+        dmx_frame(16, 0x00),      // init the dmx frame to all zeros
+        silence(frame->silent())  // is this silence?
   {
     add_kv("seq_num", frame->seq_num);
     add_kv("timestamp", frame->timestamp); // RTSP timestamp
@@ -72,8 +73,11 @@ public:
     return msg;
   }
 
-private:
+public:
   // order dependent
+  const seq_num_t seq_num;
+
+private:
   static constexpr csv TYPE{"data"};
   uint8v dmx_frame;
   bool silence{false};
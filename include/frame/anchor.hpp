@@ -22,29 +22,95 @@
 #include "base/types.hpp"
 #include "frame/anchor_data.hpp"
 #include "frame/anchor_last.hpp"
+#include "frame/clock_filter.hpp"
 #include "frame/clock_info.hpp"
 
 #include <array>
+#include <atomic>
 #include <memory>
+#include <mutex>
 #include <optional>
 
 namespace pierre {
 
+/// @brief The sender's anchor (SETRATEANCHORTIME) localized with the master
+///        clock.  Writers (RTSP) publish immutable, versioned source anchors,
+///        the render path (Racked) picks up the latest version without locking
+///        and derives AnchorLast from it.  Each derived AnchorLast carries a
+///        generation so holders (e.g. Frame) can tell when their copy is
+///        outdated.
 class Anchor {
 public:
-  Anchor() = default;
+  Anchor() noexcept;
   static void init(); // create shared Anchor
 
+  /// @brief Localized anchor (render path only, a single caller).  Derives a
+  ///        new AnchorLast only when the clock sample or source anchor changed.
+  ///        Wait-free.
+  /// @param clock latest ClockInfo (see MasterClock::snapshot())
+  /// @return AnchorLast (ready() == false until there is an anchor and clock)
   static AnchorLast get_data(const ClockInfo &clock) noexcept;
+
+  /// @brief The AnchorLast most recently derived by get_data(), for any thread.
+  ///        Only the fields required to convert between frame and local time
+  ///        are copied.  Wait-free unless get_data() is sharing concurrently.
+  /// @return AnchorLast (ready() == false when there is none)
+  static AnchorLast latest() noexcept;
+
+  /// @brief Publish a new source anchor (writers are serialized)
   static void save(AnchorData ad) noexcept;
+
+  /// @brief Publish the absence of an anchor, AnchorLast is reset
   static void reset() noexcept;
 
 private:
+  struct source_t {
+    std::optional<AnchorData> data;
+    uint64_t generation{0};
+    bool reset_last{false};    // no anchor, discard AnchorLast
+    bool params_change{false}; // same clock, new rtp or anchor time
+  };
+
   AnchorLast get_data_impl(const ClockInfo &clock) noexcept;
 
+  /// @brief Share the derived AnchorLast with other threads (see latest())
+  void share() noexcept;
+
+  /// @brief Publish a source anchor to a slot neither the latest nor being
+  ///        read by get_data() (caller must hold source_mtx)
+  void publish(source_t &&next) noexcept;
+
+  /// @brief Apply a source anchor published since the previous call
+  /// @return true when there was a new source anchor
+  bool source_pickup() noexcept;
+
 private:
+  // writers never overwrite the latest or the slot get_data() has announced
+  // it is reading (a single reader hazard) so three slots always suffice
+  static constexpr size_t SLOTS{4};
+
+  // published source anchors (save(), reset())
+  std::mutex source_mtx; // writers only
+  std::array<source_t, SLOTS> sources;
+  size_t source_next{0};
+  std::atomic<const source_t *> source_latest;
+  std::atomic<const source_t *> source_reading{nullptr};
+
+  // render path (get_data) only
   std::optional<AnchorData> source;
+  uint64_t source_generation{0};
+  uint64_t generation{0}; // of the derived AnchorLast
   AnchorLast last;
+  ClockFilter clock_filter; // smoothed master clock offset
+
+  // latest AnchorLast shared with other threads, a sequence lock (odd while
+  // get_data() is writing) over atomic copies of the fields
+  std::atomic<uint64_t> shared_seq{0};
+  std::atomic<ClockID> shared_clock_id{0};
+  std::atomic<uint32_t> shared_rtp_time{0};
+  std::atomic<int64_t> shared_localized{0};
+  std::atomic<int64_t> shared_updated_at{0};
+  std::atomic<double> shared_drift{0};
 
 public:
   static constexpr auto module_id{"anchor"};
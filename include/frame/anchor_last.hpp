@@ -38,6 +38,9 @@ public:
   Nanos localized{0};
   Elapsed since_update;
   Nanos master_at{0};
+  Nanos updated_at{0};    // local time localized was calculated
+  uint64_t generation{0}; // increases each time Anchor derives a new AnchorLast
+  double drift{0};        // master clock offset drift (ns per ns, see ClockFilter)
 
   AnchorLast() = default;
 
@@ -55,11 +58,15 @@ public:
     int32_t frame_diff = timestamp - rtp_time;
     Nanos time_diff = Nanos((frame_diff * pet::NS_FACTOR.count()) / InputInfo::rate);
 
-    return localized + time_diff;
+    // the offset keeps drifting after the update, the local time of a frame
+    // further from the update is adjusted by the drift to that point
+    const auto local = localized + time_diff;
+
+    return local - drifted(local);
   }
 
   timestamp_t local_to_frame_time(const Nanos local_time = pet::now_monotonic()) const noexcept {
-    Nanos time_diff = local_time - localized;
+    Nanos time_diff = local_time - localized + drifted(local_time);
     Nanos frame_diff = time_diff * InputInfo::rate;
 
     return rtp_time + (frame_diff.count() / pet::NS_FACTOR.count());
@@ -68,11 +75,20 @@ public:
   bool ready() const noexcept { return clock_id != 0; }
   void reset() noexcept { *this = AnchorLast(); }
 
-  void update(const AnchorData &ad, const ClockInfo &clock) noexcept {
+  /// @brief Localize the anchor
+  /// @param ad source anchor
+  /// @param clock master clock (clock id and mastership start)
+  /// @param offset master clock offset at now (filtered, see ClockFilter)
+  /// @param offset_drift offset drift (ns per ns)
+  /// @param now local time of offset
+  void update(const AnchorData &ad, const ClockInfo &clock, uint64_t offset, double offset_drift,
+              Nanos now) noexcept {
 
     rtp_time = ad.rtp_time;
     anchor_time = ad.anchor_time;
-    localized = pet::subtract_offset(anchor_time, clock.rawOffset);
+    localized = pet::subtract_offset(anchor_time, offset);
+    updated_at = now;
+    drift = offset_drift;
     since_update.reset();
 
     if (clock_id == 0x00) { // only update master when AnchorLast isn't ready
@@ -81,6 +97,12 @@ public:
     }
   }
 
+private:
+  // offset drift between the update and a local time
+  Nanos drifted(Nanos local) const noexcept {
+    return Nanos(static_cast<int64_t>(drift * (local - updated_at).count()));
+  }
+
 public:
   static constexpr csv module_id{"anchor.last"};
 };
@@ -28,15 +28,19 @@ extern "C" {
 }
 #endif
 
+#include "decimator.hpp"
 #include "dsp.hpp"
 #include "fft.hpp"
 #include "frame.hpp"
 #include "io/io.hpp"
 #include "lcs/logger.hpp"
 
+#include <array>
 #include <atomic>
+#include <cstdint>
 #include <memory>
 #include <optional>
+#include <vector>
 
 namespace pierre {
 
@@ -46,20 +50,10 @@ public:
   Av(io_context &io_ctx) noexcept;
   ~Av() noexcept;
 
-  /// @brief allocate space for the ADTS header and cipher
-  /// @returns pointer to memory block for encrypted data
-  static uint8_t *m_buffer(cipher_buff_t &m, ptrdiff_t bytes) noexcept {
-    m.emplace(ADTS_HEADER_SIZE + bytes, 0x00);
-
-    return m->data() + ADTS_HEADER_SIZE;
-  }
-
-  /// @brief resizes 'm' to accomodate bytes consumed by deciphering
-  /// @param m buffer to resize
-  /// @param consumed bytes deciphered
-  static void m_buffer_resize(cipher_buff_t &m, unsigned long long consumed) noexcept {
-    m->resize(consumed + ADTS_HEADER_SIZE);
-  }
+  /// @brief Configure the decoder for the stream announced by SETUP, must be
+  ///        serialized with parse() (e.g. the Racked decode stage)
+  /// @param ct SETUP compression type
+  void configure(uint64_t ct) noexcept;
 
   /// @brief Parse (decode) deciphered frame to audio frame then perform FFT
   /// @param frame Frame to parse
@@ -67,12 +61,28 @@ public:
   bool parse(frame_t frame) noexcept;
 
 private:
-  bool decode_failed(const frame_t &frame, AVPacket **pkt,
-                     AVFrame **audio_frame = nullptr) noexcept;
+  // raw: access units sent directly to a decoder configured with the
+  //      AudioSpecificConfig (extradata)
+  // adts: ADTS header synthesized ahead of each access unit then parsed
+  //       (fallback when raw access units of a stream never decode)
+  enum decode_path : uint8_t { RAW = 0, ADTS };
+
+  /// @brief Packet for the ADTS path (header and access unit copied to adts_buff)
+  bool adts_packet(const frame_t &frame) noexcept;
+
+  bool decode_failed(const frame_t &frame) noexcept;
 
   void log_diag_info(AVFrame *audio_frame) noexcept;
 
-  static void log_discard(frame_t frame, int used) noexcept;
+  /// @brief Silent (or below the floor) decoded frame, checked before the FFT.
+  ///        The decoder always runs, AAC frames depend on the previous frame.
+  bool silent(const frame_t &frame, const float *left, const float *right,
+              int samples) const noexcept;
+
+  static void log_discard(frame_t frame, int used, int encoded_size) noexcept;
+
+  /// @brief (Re)open the decoder for a decode path
+  bool open(decode_path want) noexcept;
 
 private:
   static constexpr int ADTS_PROFILE{2};     // AAC LC
@@ -80,6 +90,15 @@ private:
   static constexpr int ADTS_CHANNEL_CFG{2}; // CPE
   static constexpr std::ptrdiff_t ADTS_HEADER_SIZE{7};
 
+  // AudioSpecificConfig (ISO 14496-3) of the same stream: object type (5 bits),
+  // frequency index (4 bits), channel config (4 bits), GASpecificConfig (3 bits)
+  static constexpr std::array<uint8_t, 2> ASC{
+      (ADTS_PROFILE << 3) | (ADTS_FREQ_IDX >> 1),           // 0x12
+      ((ADTS_FREQ_IDX & 1) << 7) | (ADTS_CHANNEL_CFG << 3)}; // 0x10
+
+  static constexpr uint64_t CT_AAC_LC{4};   // SETUP compression type
+  static constexpr int RAW_FAILURES_MAX{3}; // consecutive raw failures before ADTS
+
 private:
   // order dependent
   std::atomic_bool ready; // AV functionality setup and ready
@@ -88,10 +107,26 @@ private:
   // order independent
   AVCodec *codec{nullptr};
   AVCodecContext *codec_ctx{nullptr};
-  AVCodecParserContext *parser_ctx{nullptr};
+  AVCodecParserContext *parser_ctx{nullptr}; // adts path only
+
+  // reused for every frame (parse is serialized)
+  AVPacket *pkt{nullptr};
+  AVFrame *audio_frame{nullptr};
+  std::vector<uint8_t> adts_buff; // grows to the largest frame
+
+  decode_path path{RAW};
+  int raw_failures{0};
+  bool raw_decoded{false}; // raw path decoded a frame of this stream
+
+  // silence detection (frame.av.silence)
+  float silence_mean_sq{0};        // mean square (per channel) below this is silent
+  std::ptrdiff_t silence_bytes{0}; // encoded frames this size or smaller are silent, 0 = off
+
+  // band limited analysis (frame.dsp.decimate), empty when not decimating
+  std::vector<Decimator> decimators; // left, right
 
 public:
   static constexpr csv module_id{"frame.av"};
 };
 
-} // namespace pierre
\ No newline at end of file
+} // namespace pierre
@@ -0,0 +1,98 @@
+//  Pierre - Custom Light Show for Wiss Landing
+//  Copyright (C) 2022  Tim Hughey
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//  https://www.wisslanding.com
+
+#pragma once
+
+#include "base/pet.hpp"
+#include "base/types.hpp"
+#include "frame/clock_info.hpp"
+
+#include <array>
+#include <cstdint>
+
+namespace pierre {
+
+/// @brief Smoothed master clock offset.  nqptp publishes a raw offset every
+///        ~122ms and each sample carries its own measurement noise.  A least
+///        squares line through the recent (sample time, raw offset) pairs of the
+///        current master clock gives the offset at any local time, corrected
+///        for drift, without the jitter of the individual samples.
+///
+///        A new master clock or a step (a sample far from the line) restarts
+///        the fit.  Not thread safe, owned by Anchor.
+class ClockFilter {
+public:
+  ClockFilter() = default;
+
+  /// @brief Add the sample of a ClockInfo, samples already seen (MasterClock
+  ///        snapshots between nqptp updates) are ignored
+  /// @param clock ClockInfo from MasterClock
+  /// @return true when the sample was added
+  bool add(const ClockInfo &clock) noexcept;
+
+  /// @brief Offset (master clock time = local time + offset) at a local time
+  /// @param local local (monotonic raw) time
+  /// @return the fitted offset or zero when there are no samples
+  uint64_t offset_at(Nanos local = pet::now_monotonic()) const noexcept;
+
+  /// @brief Offset drift (ns per ns, zero until there are enough samples)
+  double drift() const noexcept { return slope; }
+
+  bool ready() const noexcept { return count > 0; }
+
+  /// @brief Residual (sample - fit) of the most recently added sample
+  Nanos residual() const noexcept { return Nanos(last_residual); }
+
+  void reset() noexcept { *this = ClockFilter(); }
+
+private:
+  void fit() noexcept;
+
+  double predict(double x) const noexcept { return intercept + (slope * x); }
+
+  /// @brief Discard the samples, the next sample becomes the origin
+  void restart(const ClockInfo &clock) noexcept;
+
+private:
+  struct sample {
+    double x{0}; // sample time since origin (ns)
+    double y{0}; // offset relative to origin (ns)
+  };
+
+  static constexpr size_t WINDOW{32};          // ~4s of nqptp samples
+  static constexpr size_t FIT_MIN{4};          // fewer samples use the mean offset
+  static constexpr int64_t STEP_MAX{1'000'000}; // residual beyond 1ms is a step
+
+  ClockID clock_id{0};
+  uint64_t origin_time{0};   // sample time of the first sample
+  uint64_t origin_offset{0}; // raw offset of the first sample
+  uint64_t last_sample_time{0};
+
+  std::array<sample, WINDOW> samples{};
+  size_t next{0};
+  size_t count{0};
+
+  double intercept{0};
+  double slope{0};
+  int64_t last_residual{0};
+
+public:
+  static constexpr csv module_id{"frame.clock.filter"};
+};
+
+} // namespace pierre
@@ -0,0 +1,93 @@
+//  Pierre - Custom Light Show for Wiss Landing
+//  Copyright (C) 2022  Tim Hughey
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//  https://www.wisslanding.com
+
+#pragma once
+
+#include "base/types.hpp"
+#include "frame/fft.hpp"
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+namespace pierre {
+
+/// @brief Low-pass and decimate (by 2 or 4) one channel ahead of the FFT so a
+///        smaller FFT covers only the band the effects use at the same bin
+///        spacing (sample rate and FFT size both shrink by the factor).
+///
+///        Each halving is a short half-band FIR computed in polyphase form: the
+///        input is split into its even and odd samples, only the kept outputs
+///        are computed and the odd phase is the center tap alone so each output
+///        costs about TAPS / 2 multiplies.  By 4 is two halvings.
+///
+///        The filter runs on the (serialized) decode stage so it is kept short,
+///        the transition band straddles the decimated nyquist: flat (-0.3dB) to
+///        rate / 5.5 (8kHz at 44.1kHz), rejects (-50dB) from rate / 2.9.  What
+///        aliases lands in the top of the decimated band, above the flat region.
+///
+///        The filter history carries across calls so consecutive frames of a
+///        channel are filtered as one stream.  Not thread safe, owned by Av
+///        (decode is serialized).
+class Decimator {
+public:
+  static constexpr size_t TAPS{19};         // per halving, 4k - 1 for a half-band filter
+  static constexpr double KAISER_BETA{5.0}; // window, trades transition width for rejection
+
+public:
+  /// @param factor 1 (passthrough), 2 or 4, anything else is treated as 1
+  Decimator(size_t factor) noexcept;
+
+  size_t factor() const noexcept { return size_t{1} << halvings.size(); }
+
+  /// @brief Filter and decimate
+  /// @param in samples (at most FFT::SAMPLES)
+  /// @param samples count of in
+  /// @param out receives samples / factor()
+  /// @return samples written to out
+  size_t process(const float *in, size_t samples, float *out) noexcept;
+
+  /// @brief Discard the filter history (e.g. the stream restarted)
+  void reset() noexcept;
+
+private:
+  static constexpr size_t CENTER{TAPS / 2};      // odd, the only odd phase tap
+  static constexpr size_t EVEN_TAPS{CENTER + 1}; // taps 0, 2 ... TAPS - 1
+  static constexpr size_t HISTORY{CENTER};       // per phase, (TAPS - 1) / 2
+  static constexpr size_t BLOCK{16};             // outputs per pass over the taps
+
+  // input split by phase, the newest HISTORY samples (of each phase) of the
+  // previous call precede the input
+  struct halving {
+    alignas(64) std::array<float, HISTORY + FFT::SAMPLES / 2> even{};
+    alignas(64) std::array<float, HISTORY + FFT::SAMPLES / 2> odd{};
+  };
+
+  size_t halve(halving &h, const float *in, size_t samples, float *out) const noexcept;
+
+private:
+  // order dependent
+  std::array<float, EVEN_TAPS> even_taps; // even phase (symmetric)
+  std::vector<halving> halvings;
+  alignas(64) std::array<float, FFT::SAMPLES / 2> between; // output of the first halving (by 4)
+
+public:
+  static constexpr csv module_id{"frame.decimator"};
+};
+
+} // namespace pierre
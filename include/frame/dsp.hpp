@@ -18,39 +18,86 @@
 
 #pragma once
 
-#include "base/thread_util.hpp"
 #include "base/uint8v.hpp"
 #include "fft.hpp"
 #include "frame.hpp"
-#include "io/io.hpp"
 #include "lcs/logger.hpp"
+#include "pipeline.hpp"
 
-#include <array>
-#include <fmt/ostream.h>
-#include <latch>
+#include <atomic>
+#include <cstdint>
 #include <memory>
+#include <optional>
+#include <vector>
 
 namespace pierre {
 
+/// @brief The parallel stage of the frame pipeline.  Decoded frames are handed
+///        round robin to worker stages (each an SpscQueue and thread) so the
+///        decode stage is the single producer of every worker queue.
+///
+///        Each worker schedules its frames earliest deadline first using the
+///        frame's anchor derived local (render) time.  Work starts once the
+///        deadline is within the horizon (frame.dsp.horizon_ms) and frames past
+///        their deadline are dropped so the frames about to render never queue
+///        behind frames seconds in the future (e.g. at start of play).  Frames
+///        without a deadline (no anchor yet) are processed on arrival.
+///
+///        Frames are racked (by seq_num) before dsp completes and render only
+///        uses frames in DSP_COMPLETE state so workers finishing out of order
+///        require no reassembly.
 class Dsp {
 
 public:
   Dsp() noexcept;
   ~Dsp() noexcept;
 
+  /// @brief Queue a decoded frame for peak detection, waits when every worker
+  ///        queue is full.  Must only be called by the decode stage.
   void process(const frame_t frame, FFT &&left, FFT &&right) noexcept;
 
 private:
-  // order dependent
-  io_context io_ctx;
-  work_guard guard;
-  std::shared_ptr<std::latch> shutdown_latch;
+  struct job {
+    frame_t frame;
+    FFT left;
+    FFT right;
+  };
+
+  using job_t = std::unique_ptr<job>;
+
+  struct worker {
+    std::vector<job_t> jobs;               // earliest deadline heap (worker thread only)
+    std::optional<Stage<job_t, 64>> stage; // last, references jobs
+  };
+
+  void _process(job &j) noexcept;
+
+  /// @brief Remove the earliest job
+  void pop(worker &w) noexcept;
+
+  /// @brief Run (or drop) the earliest job once its deadline is within the horizon
+  /// @return when to schedule again (see Stage::tick_t)
+  Nanos schedule(worker &w) noexcept;
+
+  // heap order, a later rtp timestamp (wraps) is a later deadline
+  static bool later(const job_t &a, const job_t &b) noexcept {
+    return static_cast<int32_t>(a->frame->timestamp - b->frame->timestamp) > 0;
+  }
 
 private:
-  void _process(const frame_t frame, FFT &&left, FFT &&right) noexcept;
+  static constexpr size_t HELD_MAX{512}; // per worker, beyond this the earliest runs now
+
+  // order independent
+  bool joint_stereo{false};       // analyze both channels with a single FFT
+  Nanos horizon{0};               // start work this long before the deadline
+  std::atomic<int32_t> queued{0}; // frames queued but not yet processed
+  size_t next_worker{0};          // round robin (decode stage only)
+
+  // order dependent
+  std::vector<std::unique_ptr<worker>> workers; // last, reference the above
 
 public:
-  static constexpr csv thread_prefix{"dsp"};
+  static constexpr const char *thread_prefix{"dsp"};
   static constexpr csv module_id{"frame.dsp"};
 };
 
@@ -27,10 +27,10 @@ https://www.wisslanding.com
 #include "base/types.hpp"
 #include "peaks.hpp"
 
+#include <array>
 #include <math.h>
 #include <stdint.h>
 #include <stdlib.h>
-#include <vector>
 
 namespace pierre {
 
@@ -51,35 +51,51 @@ enum class window {
 
 } // namespace fft
 
+/// @brief Real input FFT (N real samples computed as an N/2 complex FFT).
+///        Twiddles, bit reversal and window tables are built once by init() and
+///        the butterfly kernel (scalar, SSE2, AVX2 or AVX-512) is selected at
+///        runtime.  Scratch space is per thread; the FFT itself holds only the
+///        samples (replaced by magnitudes once processed).
+///
+///        Decimated input (see Decimator) uses a smaller FFT (SAMPLES / 2 or
+///        SAMPLES / 4) at the decimated sample rate, the bin spacing is unchanged.
 class FFT {
 public:
+  static constexpr size_t SAMPLES{1024};
+  static constexpr size_t DECIMATION_MAX{4};
+
+public:
+  /// @param reals samples
+  /// @param samples SAMPLES, SAMPLES / 2 or SAMPLES / 4 (decimated)
+  /// @param frequency sample rate of reals (decimated)
   FFT(const float *reals, size_t samples, const float frequency);
 
-  void compute(fft::direction dir); // computes in-place complex-to-complex FFT
   void find_peaks(Peaks &peaks, Peaks::CHANNEL channel = Peaks::CHANNEL::LEFT) noexcept;
 
   static void init();
 
-  void process();
+  void process() noexcept;
+
+  /// @brief Joint stereo: process both channels with a single N point complex FFT
+  ///        (left real, right imaginary) then separate the spectra
+  static void process(FFT &left, FFT &right) noexcept;
 
 private:
-  void complex_to_magnitude();
+  void complex_to_magnitude() noexcept;
+  void compute() noexcept; // computes real-to-complex FFT into the thread workspace
   void dc_removal() noexcept;
   Frequency freq_at_index(size_t y);
   Magnitude mag_at_index(const size_t i) const;
-  void windowing(fft::direction dir);
+  void windowing(fft::direction dir) noexcept;
 
 private:
   static constexpr float sq(const float x) { return x * x; }
 
 private:
   // order dependent
-  reals_t _reals;
+  alignas(64) std::array<float, SAMPLES> _reals;
   const float _sampling_freq;
-
-  const size_t _max_peaks;
-  reals_t _imaginary;
-  uint_fast8_t _power;
+  const size_t _n; // FFT size (samples)
 
 public:
   static constexpr csv module_id{"frame.fft"};
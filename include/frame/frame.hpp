@@ -28,33 +28,73 @@
 #include "frame/state.hpp"
 
 #include <array>
+#include <atomic>
+#include <cstddef>
 #include <future>
 #include <memory>
 #include <optional>
+#include <span>
+#include <utility>
 
 namespace pierre {
 
-using cipher_buff_t = std::optional<uint8v>;
-
 class Av;
 
 class Frame;
-using frame_t = std::shared_ptr<Frame>;
+class FramePool;
+
+/// @brief Intrusive reference counted handle to a pooled Frame (or subclass).
+///        The count lives in the Frame (no control block) and the Frame is
+///        returned to the FramePool when the last handle is released.
+class frame_t {
+public:
+  frame_t() = default;
+  frame_t(std::nullptr_t) noexcept {}
+  explicit frame_t(Frame *f) noexcept; // adds a reference
+  frame_t(const frame_t &rhs) noexcept : frame_t(rhs.f) {}
+  frame_t(frame_t &&rhs) noexcept : f(std::exchange(rhs.f, nullptr)) {}
+  ~frame_t() noexcept { reset(); }
+
+  frame_t &operator=(const frame_t &rhs) noexcept {
+    frame_t(rhs).swap(*this);
+    return *this;
+  }
+
+  frame_t &operator=(frame_t &&rhs) noexcept {
+    frame_t(std::move(rhs)).swap(*this);
+    return *this;
+  }
+
+  explicit operator bool() const noexcept { return f != nullptr; }
+  Frame &operator*() const noexcept { return *f; }
+  Frame *operator->() const noexcept { return f; }
+  Frame *get() const noexcept { return f; }
+
+  void reset() noexcept;
+  void swap(frame_t &rhs) noexcept { std::swap(f, rhs.f); }
+  long use_count() const noexcept;
+
+private:
+  Frame *f{nullptr};
+};
+
 using frame_future = std::shared_future<frame_t>;
 using frame_promise = std::promise<frame_t>;
 
-class Frame : public std::enable_shared_from_this<Frame> {
+class Frame {
+  friend class frame_t;
+  friend class FramePool;
 
 private: // use create()
   Frame(uint8v &packet) noexcept
       : state(frame::HEADER_PARSED),              // frame header parsed
+        seq_num(packet.to_uint32(1, 3)),          // rtp seq num note: only three bytes
+        timestamp(packet.to_uint32(4, 4)),        // rtp timestamp
         version((packet[0] & 0b11000000) >> 6),   // RTPv2 == 0x02
         padding((packet[0] & 0b00100000) >> 5),   // has padding
         extension((packet[0] & 0b00010000) >> 4), // has extension
         ssrc_count((packet[0] & 0b00001111)),     // source system record count
-        ssrc(packet.to_uint32(8, 4)),             // source system record count
-        seq_num(packet.to_uint32(1, 3)),          // rtp seq num note: only three bytes
-        timestamp(packet.to_uint32(4, 4))         // rtp timestamp
+        ssrc(packet.to_uint32(8, 4))              // source system record count
   {}
 
 protected: // subclass use only
@@ -65,18 +105,25 @@ protected: // subclass use only
   {}
 
 public:
-  static auto create(uint8v &packet) noexcept { //
-    return std::shared_ptr<Frame>(new Frame(packet));
-  }
+  virtual ~Frame() noexcept = default;
+
+  /// @brief Create a Frame from a received packet (allocated from the FramePool)
+  static frame_t create(uint8v &packet) noexcept;
 
-  auto ptr() noexcept { return shared_from_this(); }
+  frame_t ptr() noexcept { return frame_t(this); }
 
   // Public API
-  bool decipher(uint8v packet, const uint8v key) noexcept;
+  bool decipher(uint8v &&p, const uint8v &key) noexcept;
   bool deciphered() const noexcept { return state >= frame::state(frame::DECIPHERED); }
   bool decode(Av *av) noexcept;
   void flushed() noexcept { state = frame::FLUSHED; }
 
+  /// @brief Release the (deciphered) packet once decoded
+  void release_packet() noexcept {
+    m = std::span<uint8_t>();
+    uint8v().swap(packet);
+  }
+
   static void init(); // Digital Signal Analysis (hidden in .cpp)
 
   void mark_rendered() noexcept {
@@ -87,7 +134,8 @@ public:
 
   bool silent() const noexcept { return peaks.silence(); }
 
-  frame::state state_now(AnchorLast anchor, const Nanos &lead_time = InputInfo::lead_time) noexcept;
+  frame::state state_now(const AnchorLast &anchor,
+                         const Nanos &lead_time = InputInfo::lead_time) noexcept;
   frame::state state_now(const Nanos diff, const Nanos &lead_time = InputInfo::lead_time) noexcept;
 
   // sync_wait() and related functions can be overriden by subclasses
@@ -103,13 +151,27 @@ public:
   static const string inspect_safe(frame_t frame, bool full = false) noexcept;
   void log_decipher() const noexcept;
 
+private:
+  static void recycle(Frame *f) noexcept; // return to FramePool (frame_pool.cpp)
+
 protected:
   Nanos set_sync_wait(const Nanos diff) noexcept { return _sync_wait.emplace(diff); }
 
+private:
+  // hot, first cache line: consulted by Racked::next_frame() and Desk for
+  // every frame (together with the vptr these fit within 64 bytes)
+  std::atomic<uint32_t> refs{0}; // intrusive reference count, see frame_t
+  uint32_t slot{0};              // FramePool slot (or heap)
+
 public:
   // order dependent
-  Elapsed lifespan;
   frame::state state;
+  seq_num_t seq_num{0};
+  timestamp_t timestamp{0};
+
+protected:
+  // calculated by state_now() or recalculated by sync_wait_recalc()
+  std::optional<Nanos> _sync_wait;
 
 private:
   // order dependent (no need to expose publicly)
@@ -120,12 +182,10 @@ private:
   uint32_t ssrc{0};
 
 public:
-  // order dependent (must expose publicly)
-  seq_num_t seq_num{0};
-  timestamp_t timestamp{0};
-
   // order independent
-  cipher_buff_t m; // temporary buffer for ciphering
+  Elapsed lifespan;
+  uint8v packet;        // received packet, deciphered in place
+  std::span<uint8_t> m; // deciphered audio (within packet)
 
   // decode frame (exposed publicly for av decode)
   int samples_per_channel{0};
@@ -134,17 +194,9 @@ public:
   // populated by DSP or empty (silent)
   Peaks peaks;
 
-  // populated by Reel
-  reel_serial_num_t reel{0};
-
-protected:
-  // calculated by state_now() or recalculated by sync_wait_recalc()
-  std::optional<Nanos> _sync_wait;
-
 private:
   // order independent
-  int cipher_rc{0};                  // decipher support
-  static ptrdiff_t cipher_buff_size; // in bytes, populated by init()
+  int cipher_rc{0}; // decipher support
 
   std::optional<AnchorLast> _anchor;
 
@@ -153,4 +205,25 @@ public:
   static constexpr csv module_id{"frame"};
 };
 
+// frame_t is defined before Frame, implement the reference counting here
+
+inline frame_t::frame_t(Frame *f) noexcept : f(f) {
+  if (f) f->refs.fetch_add(1, std::memory_order_relaxed);
+}
+
+inline long frame_t::use_count() const noexcept {
+  return f ? f->refs.load(std::memory_order_relaxed) : 0;
+}
+
+inline void frame_t::reset() noexcept {
+  if (auto *x = std::exchange(f, nullptr); x) {
+    // the sole owner can skip the (relatively expensive) atomic decrement
+    // since no other handle exists that could add a reference
+    if ((x->refs.load(std::memory_order_acquire) == 1) ||
+        (x->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)) {
+      Frame::recycle(x);
+    }
+  }
+}
+
 } // namespace pierre
\ No newline at end of file
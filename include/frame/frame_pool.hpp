@@ -0,0 +1,80 @@
+//  Pierre - Custom Light Show for Wiss Landing
+//  Copyright (C) 2022  Tim Hughey
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//  https://www.wisslanding.com
+
+#pragma once
+
+#include "base/types.hpp"
+#include "frame/frame.hpp"
+#include "frame/jitter_buffer.hpp"
+#include "frame/silent_frame.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace pierre {
+
+/// @brief Preallocated slab of Frame (and SilentFrame) storage.  Slots are
+///        handed out by acquire() and returned by the last frame_t referencing
+///        the Frame.  Frames are allocated from the heap only when the slab is
+///        exhausted (e.g. a consumer holding frames far longer than expected).
+class FramePool {
+  friend class Frame;
+
+public:
+  // every racked frame plus those in flight (decode, dsp, render, silence)
+  static constexpr uint32_t SLOTS{JitterBuffer::CAPACITY + 256};
+  static constexpr uint32_t NO_SLOT{UINT32_MAX};
+  static constexpr size_t SLOT_ALIGN{64}; // cache line
+  static constexpr size_t SLOT_BYTES{
+      ((std::max(sizeof(Frame), sizeof(SilentFrame)) + SLOT_ALIGN - 1) / SLOT_ALIGN) * SLOT_ALIGN};
+
+public:
+  /// @brief Construct a Frame (or subclass) in a free slot
+  /// @tparam T Frame or subclass
+  /// @param args constructor args
+  /// @return frame_t referencing the new Frame
+  template <typename T, typename... Args> static frame_t acquire(Args &&...args) noexcept {
+    static_assert(std::is_base_of_v<Frame, T>, "only Frames are pooled");
+    static_assert((sizeof(T) <= SLOT_BYTES) && (alignof(T) <= SLOT_ALIGN), "T exceeds slot");
+
+    const auto slot = pop();
+    void *mem = (slot != NO_SLOT) ? slot_ptr(slot) : heap_alloc();
+
+    auto *f = new (mem) T(std::forward<Args>(args)...);
+    f->slot = slot;
+
+    return frame_t(f);
+  }
+
+  /// @brief Count of free slots (approximate when frames are in motion)
+  static uint32_t available() noexcept;
+
+private:
+  static void *heap_alloc() noexcept;
+  static uint32_t pop() noexcept;
+  static void push(uint32_t slot) noexcept;
+  static void *slot_ptr(uint32_t slot) noexcept;
+
+public:
+  static constexpr csv module_id{"frame.pool"};
+};
+
+} // namespace pierre
@@ -0,0 +1,145 @@
+//  Pierre - Custom Light Show for Wiss Landing
+//  Copyright (C) 2022  Tim Hughey
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//  https://www.wisslanding.com
+
+#pragma once
+
+#include "base/types.hpp"
+#include "frame/flush_info.hpp"
+#include "frame/frame.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <fmt/format.h>
+#include <memory>
+
+namespace pierre {
+
+/// @brief Fixed capacity ring of decoded frames indexed by seq_num.
+///        Exactly one producer (decode) calls push() and exactly one consumer
+///        (next_frame) calls apply_flush(), peek() and consume().  flush() may be
+///        called from a third (serialized) context; the flush is applied by the
+///        consumer so neither the producer nor the consumer ever waits on a lock.
+///
+///        Frames are placed relative to the newest racked seq_num.  The ring is
+///        re-based (the next frame lands at tail regardless of seq_num) only at
+///        start of play, after a flush or on a forward jump beyond CAPACITY;
+///        a drained ring still rejects frames at or before the newest seq_num.
+class JitterBuffer {
+public:
+  static constexpr ssize_t CAPACITY{2048}; // ~47s of audio, must be a power of two
+
+  // PUSHED and DISCONTINUITY (re-based on a forward jump) rack the frame
+  enum push_rc : uint8_t { PUSHED = 0, LATE, OVERFLOW, DISCONTINUITY };
+
+private:
+  using idx_t = uint64_t; // monotonic (extended) seq_num, never wraps
+
+  struct pending_flush {
+    FlushInfo info;
+    idx_t until{0}; // frames at or beyond this index arrived after the flush request
+  };
+
+  static constexpr idx_t MASK{CAPACITY - 1};
+  static constexpr seq_num_t SEQ_BITS{24}; // AirPlay 2 buffered audio seq_num is 24 bits
+  static constexpr seq_num_t SEQ_MOD{1u << SEQ_BITS};
+
+  static_assert((CAPACITY & MASK) == 0, "CAPACITY must be a power of two");
+
+public:
+  JitterBuffer() = default;
+  ~JitterBuffer() noexcept { delete pending.exchange(nullptr); }
+
+  /// @brief Producer: place a decoded frame into the slot for its seq_num
+  /// @param frame Frame to rack
+  /// @return push_rc indicating if the frame was racked or why it was dropped
+  push_rc push(frame_t frame) noexcept;
+
+  static constexpr bool racked(push_rc rc) noexcept {
+    return (rc == PUSHED) || (rc == DISCONTINUITY);
+  }
+
+  /// @brief Consumer: apply the most recent flush request, if any
+  /// @return number of frames flushed or -1 when no flush was pending
+  int64_t apply_flush() noexcept;
+
+  /// @brief Consumer: discard the frame at the head of the ring
+  void consume() noexcept {
+    const auto h = head.load(std::memory_order_relaxed);
+
+    slots[h & MASK].reset();
+    head.store(h + 1, std::memory_order_release);
+  }
+
+  bool empty() const noexcept { return size() == 0; }
+
+  /// @brief Record a flush request for the consumer to apply, the producer
+  ///        re-bases on the next frame pushed
+  /// @param request FlushInfo describing the frames to flush
+  void flush(const FlushInfo &request) noexcept;
+
+  /// @brief Consumer: skip any gaps (missing seq_nums) and return the next frame
+  /// @return the next frame in seq_num order or an empty frame_t
+  frame_t peek() noexcept;
+
+  /// @brief Approximate count of slots between head and tail (includes gaps)
+  ssize_t size() const noexcept {
+    const auto t = tail.load(std::memory_order_acquire);
+    const auto h = head.load(std::memory_order_acquire);
+
+    return t > h ? static_cast<ssize_t>(t - h) : 0;
+  }
+
+  /// @brief Wraparound aware difference between two 24-bit seq_nums
+  static constexpr int32_t seq_diff(seq_num_t a, seq_num_t b) noexcept {
+    int32_t d = (a - b) & (SEQ_MOD - 1);
+
+    return (d >= static_cast<int32_t>(SEQ_MOD >> 1)) ? d - static_cast<int32_t>(SEQ_MOD) : d;
+  }
+
+private:
+  // the ring itself, frames are only ever moved in/out (no node allocations)
+  std::array<frame_t, CAPACITY> slots;
+
+  // consumer owned (written only by the consumer)
+  alignas(64) std::atomic<idx_t> head{0};
+
+  // producer owned (written only by the producer)
+  alignas(64) std::atomic<idx_t> tail{0};
+  seq_num_t last_seq{0};
+  idx_t last_idx{0};
+
+  // flush requests are handed to the consumer via pointer exchange
+  alignas(64) std::atomic<pending_flush *> pending{nullptr};
+  std::atomic_bool rebase{true}; // set by flush(), cleared by the producer
+
+public:
+  static constexpr csv module_id{"frame.jitter_buffer"};
+};
+
+} // namespace pierre
+
+/// @brief Custom formatter for JitterBuffer
+template <> struct fmt::formatter<pierre::JitterBuffer> : formatter<std::string> {
+
+  // parse is inherited from formatter<string>.
+  template <typename FormatContext>
+  auto format(const pierre::JitterBuffer &jb, FormatContext &ctx) const {
+    return formatter<std::string>::format(fmt::format("JB size={:<4}", jb.size()), ctx);
+  }
+};
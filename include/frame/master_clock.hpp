@@ -18,7 +18,6 @@
 
 #pragma once
 
-#include "base/input_info.hpp"
 #include "base/pet.hpp"
 #include "base/types.hpp"
 #include "base/uint8v.hpp"
@@ -27,12 +26,12 @@
 #include "lcs/logger.hpp"
 
 #include <array>
+#include <atomic>
 #include <chrono>
 #include <cstddef>
 #include <cstdint>
 #include <exception>
 #include <functional>
-#include <future>
 #include <latch>
 #include <memory>
 #include <pthread.h>
@@ -45,9 +44,10 @@ class MasterClock {
 private:
   static constexpr auto LOCALHOST{"127.0.0.1"};
   static constexpr uint16_t CTRL_PORT{9000}; // see note
-  static constexpr uint16_t NQPTP_VERSION{8};
 
 public:
+  static constexpr uint16_t NQPTP_VERSION{8};
+
   struct nqptp {
     pthread_mutex_t copy_mutes;           // for safely accessing the structure
     uint16_t version;                     // check version==VERSION
@@ -62,40 +62,12 @@ public:
   MasterClock() noexcept;
   ~MasterClock() noexcept;
 
-  /// @brief Get ClockInfo via a shared future. The minimum time allowed between requests is
-  ///        configured via the external .toml file.  If called before the minimum time
-  ///        has elpased this function will immediately set the future with an empty
-  ///        ClockInfo object.
-  /// @return std::shared_future<ClockInfo>
-  clock_info_future info() noexcept { // static
-    auto prom = std::make_shared<std::promise<ClockInfo>>();
-
-    auto clock_info = load_info_from_mapped();
-
-    if (clock_info.ok()) {
-      // clock info is good, immediately set the future
-      prom->set_value(clock_info);
-    } else {
-      // perform the retry on the MasterClock io_ctx enabling caller to continue other work
-      // while the clock becomes useable and the future is set to ready
-
-      auto timer = std::make_unique<steady_timer>(io_ctx);
-      // get a pointer to the timer since we move the timer into the async_wait
-      auto t = timer.get();
-
-      t->expires_after(InputInfo::lead_time_min);
-      t->async_wait([this, timer = std::move(timer), prom = prom](error_code ec) {
-        // if success get and return ClockInfo (could be ok() == false)
-        if (!ec) {
-          prom->set_value(std::move(load_info_from_mapped()));
-        } else {
-          prom->set_value(ClockInfo());
-        }
-      });
-    }
-
-    return prom->get_future().share();
-  }
+  /// @brief Latest ClockInfo sampled from nqptp by the refresher (every
+  ///        master_clock.refresh_ms, default is the nqptp update cadence).
+  ///        A sequence lock copy, no shm mutex; retries only when it overlaps
+  ///        a refresh.
+  /// @return ClockInfo (ok() == false until nqptp is available)
+  ClockInfo snapshot() const noexcept;
 
   void peers(const Peers &peer_list) noexcept { peers_update(peer_list); }
   void peers_reset() noexcept { peers_update(Peers()); }
@@ -116,30 +88,40 @@ private:
     return ok;
   }
 
-  const ClockInfo load_info_from_mapped();
+  const ClockInfo load_info_from_mapped() noexcept;
   bool map_shm();
 
-  void peers_update(const Peers &peers);
-
-  bool ready() noexcept {
-    const auto &clock_info = load_info_from_mapped();
+  void refresh() noexcept;
+  void share(const ClockInfo &info) noexcept;
 
-    return clock_info.ok() && clock_info.master_for_at_least(333ms);
-  }
+  void peers_update(const Peers &peers);
 
 private:
   // order dependent
   io_context io_ctx;
   work_guard guard;
+  steady_timer refresh_timer;
   udp_socket socket;
   udp_endpoint remote_endpoint;
   const string shm_name; // shared memmory segment name (built by constructor)
   const int thread_count;
+  const Millis refresh_interval;
   std::shared_ptr<std::latch> shutdown_latch;
 
   // order independent
   void *mapped{nullptr}; // mmapped region of nqptp data struct
 
+  // latest ClockInfo shared with snapshot(), a sequence lock (odd while
+  // refresh() is writing) over atomic copies of the fields, the master
+  // clock ip is copied as words (nul padded)
+  static constexpr size_t IP_WORDS{sizeof(nqptp::master_clock_ip) / sizeof(uint64_t)};
+  std::atomic<uint64_t> shared_seq{0};
+  std::atomic<ClockID> shared_clock_id{0};
+  std::array<std::atomic<uint64_t>, IP_WORDS> shared_ip{};
+  std::atomic<uint64_t> shared_sample_time{0};
+  std::atomic<uint64_t> shared_raw_offset{0};
+  std::atomic<int64_t> shared_start_time{0};
+
 public:
   static constexpr csv module_id{"master_clock"};
 };
@@ -23,10 +23,9 @@
 
 #include <algorithm>
 #include <array>
-#include <functional>
+#include <cstdint>
 #include <iterator>
-#include <map>
-#include <memory>
+#include <span>
 #include <type_traits>
 
 namespace pierre {
@@ -35,25 +34,48 @@ class Peaks {
 public:
   enum CHANNEL : size_t { LEFT = 0, RIGHT };
 
+  static constexpr size_t CAPACITY{16};        // peaks (largest magnitude) retained per channel
+  static constexpr size_t MAX_CANDIDATES{512}; // local maxima considered per channel
+
 private:
-  // sorted descending
-  using peak_map_t = std::map<Magnitude, Peak, std::greater<Magnitude>>;
+  // retained peaks, sorted by descending magnitude (structure of arrays)
+  struct channel_peaks {
+    std::array<float, CAPACITY> freq;
+    std::array<float, CAPACITY> mag;
+    std::array<float, CAPACITY> freq_scaled; // precomputed Frequency::scaled()
+    std::array<float, CAPACITY> mag_scaled;  // precomputed Magnitude::scaled() (dB)
+    uint16_t count{0};                       // peaks retained
+    uint16_t found{0};                       // peaks within magnitude limits (see size())
+
+    Peak at(size_t i) const noexcept {
+      return Peak(freq[i], mag[i], freq_scaled[i], mag_scaled[i]);
+    }
+  };
 
 public:
   Peaks() = default;
 
 public:
-  bool emplace(Magnitude m, Frequency f, CHANNEL channel = LEFT) noexcept;
-  size_t size(CHANNEL channel = LEFT) const noexcept { return std::ssize(peaks_map[channel]); }
+  /// @brief Retain the largest peaks (by magnitude) within the configured magnitude limits.
+  ///        Equal magnitudes keep the first candidate.
+  /// @param channel channel of the candidates
+  /// @param mags candidate magnitudes (local maxima)
+  /// @param freqs candidate frequencies (same order as mags)
+  void select(CHANNEL channel, std::span<const float> mags, std::span<const float> freqs) noexcept;
+
+  /// @brief Peaks within the magnitude limits.  A repeated magnitude is
+  ///        discounted only among the retained (CAPACITY largest) peaks, a
+  ///        repeat below those is still counted.
+  size_t size(CHANNEL channel = LEFT) const noexcept { return peaks[channel].found; }
 
   bool has_peak(size_t n, CHANNEL channel = LEFT) const noexcept {
-    return peaks_map[channel].size() > n ? true : false;
+    return peaks[channel].found > n ? true : false;
   }
 
   const Peak major_peak(CHANNEL channel = LEFT) const noexcept {
-    const auto &map = peaks_map[channel];
+    const auto &p = peaks[channel];
 
-    return !std::empty(map) ? std::begin(map)->second : Peak();
+    return p.count ? p.at(0) : Peak();
   }
 
   // avoid maybe_unused in special edge cases
@@ -61,25 +83,20 @@ public:
 
   // find the first peak greater than the Frequency
   const Peak operator()(const Frequency freq, CHANNEL channel = LEFT) const noexcept {
-    Peak found;
-    const auto &map = peaks_map[channel];
-
-    if (!std::empty(map)) {
-      for (auto it = std::counted_iterator{std::begin(map), 5};
-           (it != std::default_sentinel) && !found; ++it) {
-        const auto &[mag, peak] = *it;
+    const auto &p = peaks[channel];
+    const size_t n = std::min<size_t>(p.count, 5);
 
-        if (freq > peak.frequency()) found = peak;
-      }
+    for (size_t i = 0; i < n; i++) {
+      if (freq > p.freq[i]) return p.at(i);
     }
 
-    return found;
+    return Peak();
   }
 
-  bool silence() const noexcept { return peaks_map[LEFT].empty() && peaks_map[RIGHT].empty(); }
+  bool silence() const noexcept { return !peaks[LEFT].found && !peaks[RIGHT].found; }
 
 private:
-  std::array<peak_map_t, 2> peaks_map{peak_map_t(), peak_map_t()};
+  std::array<channel_peaks, 2> peaks;
 
 public:
   static constexpr csv module_id{"frame.peaks"};
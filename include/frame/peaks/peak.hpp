@@ -34,10 +34,17 @@ namespace pierre {
 struct Peak {
 public:
   Peak() noexcept : freq(0), mag(0) {}
-  Peak(const Frequency f, const Magnitude m) noexcept : freq(f), mag(m) {}
+  Peak(const Frequency f, const Magnitude m) noexcept
+      : freq(f), mag(m), freq_scaled(f.scaled()), mag_scaled(m.scaled()) {}
+
+  // scaled values precomputed (e.g. by Peaks)
+  Peak(const Frequency f, const Magnitude m, const Frequency fs, const Magnitude ms) noexcept
+      : freq(f), mag(m), freq_scaled(fs), mag_scaled(ms) {}
 
   auto frequency() const noexcept { return freq; }
+  auto frequency_scaled() const noexcept { return freq_scaled; }
   auto magnitude() const noexcept { return mag; }
+  auto magnitude_scaled() const noexcept { return mag_scaled; }
 
   bool operator!() const noexcept { return (freq == 0) && (mag == 0); }
 
@@ -60,6 +67,8 @@ public:
 private:
   Frequency freq{0};
   Magnitude mag{0};
+  Frequency freq_scaled{0};
+  Magnitude mag_scaled{0};
 };
 
 } // namespace pierre
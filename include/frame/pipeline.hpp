@@ -0,0 +1,266 @@
+//  Pierre - Custom Light Show for Wiss Landing
+//  Copyright (C) 2022  Tim Hughey
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//  https://www.wisslanding.com
+
+#pragma once
+
+#include "base/pet.hpp"
+#include "base/types.hpp"
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <stop_token>
+#include <thread>
+#include <utility>
+
+namespace pierre {
+
+/// @brief Bounded lock-free single producer, single consumer queue.  Items are
+///        constructed in place by the producer and consumed in place (front()
+///        then pop()) by the consumer so large items (e.g. FFT) are never copied.
+template <typename T, size_t CAPACITY> class SpscQueue {
+  static_assert(CAPACITY && !(CAPACITY & (CAPACITY - 1)), "CAPACITY must be a power of two");
+
+public:
+  SpscQueue() = default;
+  SpscQueue(const SpscQueue &) = delete;
+  SpscQueue &operator=(const SpscQueue &) = delete;
+
+  /// @brief Producer: construct an item at the tail
+  /// @return false (args untouched) when the queue is full
+  template <typename... Args> bool emplace(Args &&...args) noexcept {
+    const auto t = tail.load(std::memory_order_relaxed);
+
+    if ((t - head_cached) == CAPACITY) {
+      head_cached = head.load(std::memory_order_acquire);
+      if ((t - head_cached) == CAPACITY) return false;
+    }
+
+    slots[t & MASK].emplace(std::forward<Args>(args)...);
+    tail.store(t + 1, std::memory_order_release);
+
+    return true;
+  }
+
+  /// @brief Consumer: the item at the head or nullptr when empty
+  T *front() noexcept {
+    const auto h = head.load(std::memory_order_relaxed);
+
+    if (h == tail_cached) {
+      tail_cached = tail.load(std::memory_order_acquire);
+      if (h == tail_cached) return nullptr;
+    }
+
+    return &*slots[h & MASK];
+  }
+
+  /// @brief Consumer: destroy the item returned by front()
+  void pop() noexcept {
+    const auto h = head.load(std::memory_order_relaxed);
+
+    slots[h & MASK].reset();
+    head.store(h + 1, std::memory_order_release);
+  }
+
+  bool empty() const noexcept { return size() == 0; }
+
+  size_t size() const noexcept {
+    return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+  }
+
+  static constexpr size_t capacity() noexcept { return CAPACITY; }
+
+private:
+  static constexpr size_t MASK{CAPACITY - 1};
+
+  // head and tail are on separate cache lines, each side caches the other's
+  // index so the shared line is only read when the cached index says full/empty
+  alignas(64) std::atomic<size_t> head{0};
+  size_t tail_cached{0}; // consumer only
+  alignas(64) std::atomic<size_t> tail{0};
+  size_t head_cached{0}; // producer only
+
+  alignas(64) std::array<std::optional<T>, CAPACITY> slots{};
+};
+
+namespace pipeline {
+
+/// @brief Name the calling stage thread and pin it to the cpu configured for
+///        the stage (frame.pipeline.cpu.<stage>, -1 or absent = any)
+void stage_thread_init(const char *stage, int num) noexcept;
+
+// per stage counters (stage is the stats tag and must have static storage)
+void record_depth(const char *stage, size_t depth) noexcept;
+void record_dropped(const char *stage) noexcept;
+void record_latency(const char *stage, Nanos latency) noexcept;
+
+} // namespace pipeline
+
+/// @brief A pipeline stage: an SpscQueue drained by a dedicated thread that
+///        calls the handler for each item in arrival order.  The thread sleeps
+///        when the queue is empty (and no scheduled work is due).
+///
+///        A stage that defers work (e.g. Dsp, deadline scheduled) also supplies a
+///        tick, called after each item and when the wakeup it requested is due.
+///
+///        Exactly one thread may push (the previous stage).  Items still queued
+///        when the Stage is destroyed are discarded.
+template <typename T, size_t CAPACITY> class Stage {
+public:
+  using handler_t = std::function<void(T &item)>;
+
+  // runs scheduled work, returns when to call it again (pet::now_monotonic()
+  // time) or zero when there is nothing scheduled
+  using tick_t = std::function<Nanos()>;
+
+  /// @param stage stage name (thread name and stats tag, static storage)
+  /// @param num stage thread number (e.g. parallel dsp workers), -1 = none
+  /// @param handler called on the stage thread for each item
+  /// @param tick optional scheduled work (see tick_t)
+  Stage(const char *stage, int num, handler_t handler, tick_t tick = nullptr) noexcept
+      : stage(stage), handler(std::move(handler)), tick(std::move(tick)),
+        thread([this, num](std::stop_token stoken) { run(num, stoken); }) {}
+
+  Stage(const Stage &) = delete;
+  Stage &operator=(const Stage &) = delete;
+
+  ~Stage() noexcept {
+    thread.request_stop();
+    wake(); // thread (jthread) joins when destroyed
+  }
+
+  /// @brief Enqueue an item (constructed from args) without waiting
+  /// @return false (args untouched) when the queue is full
+  template <typename... Args> bool try_push(Args &&...args) noexcept {
+    if (!queue.emplace(pet::now_monotonic(), std::forward<Args>(args)...)) return false;
+
+    pipeline::record_depth(stage, queue.size());
+    notify();
+
+    return true;
+  }
+
+  /// @brief Enqueue an item, waiting for space when the queue is full
+  ///        (backpressure on the producing stage)
+  /// @return false (args untouched) when the stage is stopping
+  template <typename... Args> bool push(Args &&...args) noexcept {
+    while (!try_push(std::forward<Args>(args)...)) {
+      if (thread.get_stop_token().stop_requested()) return false;
+
+      std::this_thread::sleep_for(FULL_WAIT);
+    }
+
+    return true;
+  }
+
+  /// @brief Enqueue an item, discarding (and counting) it when the queue is full
+  template <typename... Args> bool push_or_drop(Args &&...args) noexcept {
+    if (try_push(std::forward<Args>(args)...)) return true;
+
+    pipeline::record_dropped(stage);
+    return false;
+  }
+
+  size_t depth() const noexcept { return queue.size(); }
+
+private:
+  struct entry {
+    template <typename... Args>
+    entry(Nanos at, Args &&...args) : at(at), item{std::forward<Args>(args)...} {}
+
+    Nanos at; // enqueued at (stage latency)
+    T item;
+  };
+
+  void notify() noexcept {
+    // pairs with the fence in park(), either the consumer sees the new item or
+    // we see it sleeping
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    if (sleeping.load(std::memory_order_relaxed)) wake();
+  }
+
+  /// @brief Sleep until an item arrives, the stage stops or wake_at (zero = no
+  ///        timeout).  The mutex is only taken when the consumer sleeps.
+  void park(Nanos wake_at, std::stop_token &stoken) noexcept {
+    std::unique_lock lck(park_mtx);
+
+    sleeping.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    if (queue.empty() && !stoken.stop_requested()) {
+      if (wake_at == Nanos::zero()) {
+        park_cv.wait(lck);
+      } else {
+        park_cv.wait_for(lck, wake_at - pet::now_monotonic());
+      }
+    }
+
+    sleeping.store(false, std::memory_order_relaxed);
+  }
+
+  void run(int num, std::stop_token stoken) noexcept {
+    pipeline::stage_thread_init(stage, num);
+
+    Nanos wake_at{0}; // scheduled tick, zero when none
+
+    while (!stoken.stop_requested()) {
+      if (auto *e = queue.front(); e) {
+        pipeline::record_latency(stage, pet::now_monotonic() - e->at);
+
+        handler(e->item);
+        queue.pop();
+
+        if (tick) wake_at = tick();
+        continue;
+      }
+
+      if ((wake_at != Nanos::zero()) && (wake_at <= pet::now_monotonic())) {
+        wake_at = tick();
+        continue;
+      }
+
+      park(wake_at, stoken);
+    }
+  }
+
+  void wake() noexcept {
+    std::lock_guard lck(park_mtx);
+    park_cv.notify_one();
+  }
+
+private:
+  static constexpr Micros FULL_WAIT{250};
+
+  // order dependent
+  const char *stage;
+  handler_t handler;
+  tick_t tick;
+  SpscQueue<entry, CAPACITY> queue;
+  std::atomic_bool sleeping{false};
+  std::mutex park_mtx;
+  std::condition_variable park_cv;
+  std::jthread thread; // last, starts once everything above is constructed
+};
+
+} // namespace pierre
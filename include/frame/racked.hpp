@@ -25,40 +25,46 @@
 #include "frame/clock_info.hpp"
 #include "frame/flush_info.hpp"
 #include "frame/frame.hpp"
-#include "frame/reel.hpp"
+#include "frame/jitter_buffer.hpp"
+#include "frame/pipeline.hpp"
 #include "io/io.hpp"
 
 #include <algorithm>
 #include <atomic>
 #include <future>
 #include <latch>
-#include <map>
+#include <limits>
 #include <memory>
 #include <mutex>
 #include <optional>
 #include <ranges>
-#include <shared_mutex>
 
 namespace pierre {
 
 // forward decls to hide implementation details
 class Av;
 
-using racked_reels = std::map<reel_serial_num_t, Reel>;
-
 class Racked {
 
 public:
   Racked(MasterClock *master_clock) noexcept;
   ~Racked() noexcept;
 
+  /// @brief Configure decoding for the stream announced by SETUP
+  /// @param ct compression type
+  void audio_format(uint64_t ct) noexcept;
+
   void flush(FlushInfo &&request);
   void flush_all() noexcept { flush(FlushInfo::make_flush_all()); }
 
-  // handeff() allows the packet to be moved however expects the key to be a reference
-  void handoff(uint8v &&packet, const uint8v &key) noexcept;
+  /// @brief Pipeline ingest, queue a packet for the decipher stage (the packet
+  ///        is dropped when the decipher queue is full)
+  /// @param packet ciphered packet (moved)
+  /// @param key shared key (immutable, shared with the queued packets)
+  void handoff(uint8v &&packet, std::shared_ptr<const uint8v> key) noexcept;
 
-  /// @brief Get a shared_future to the next racked frame
+  /// @brief Get a shared_future to the next racked frame.  The future is always
+  ///        ready on return; the caller's thread is the single consumer of racked frames
   /// @return shared_future containing the next frame (could be silent)
   frame_future next_frame() noexcept;
 
@@ -69,45 +75,65 @@ public:
   }
 
 private:
-  enum log_racked_rc { NONE, RACKED, COLLISION, TIMEOUT };
+  struct ingest_t {
+    uint8v packet;
+    std::shared_ptr<const uint8v> key;
+    uint64_t flushes; // flush requests recorded when ingested
+  };
+
+  struct deciphered_t {
+    frame_t frame;
+    uint64_t flushes; // of the ingested packet
+  };
+
+  // pipeline stages (each called on the stage thread)
+  void decipher(ingest_t &in) noexcept;
+  void decode(deciphered_t &in) noexcept;
+
+  /// @brief Was a flush recorded after the frame was ingested (i.e. while it was
+  ///        queued) that applies to it?  Caller holds flush_mtx.
+  bool stale(const frame_t &frame, uint64_t flushes) const noexcept {
+    return (flushes != flush_count.load(std::memory_order_relaxed)) && flush_latest.active &&
+           flush_latest(frame);
+  }
 
-private:
-  void monitor_wip() noexcept;
-  void rack_wip() noexcept;
+  frame_t next_frame_impl() noexcept;
 
   // misc logging, debug
-  void log_racked(log_racked_rc rc = log_racked_rc::NONE) const noexcept;
+  void log_racked(JitterBuffer::push_rc rc = JitterBuffer::PUSHED) const noexcept;
 
 private:
   // order dependent
   io_context io_ctx;
   const int thread_count;
   work_guard guard;
-  strand handoff_strand;
-  strand wip_strand;
-  strand frame_strand;
   strand flush_strand;
-  steady_timer wip_timer;
   MasterClock *master_clock;
 
   // order independent
-  FlushInfo flush_request;
+  std::mutex flush_mtx;                 // decipher and decode check, flush records
+  FlushInfo flush_request;              // incoming frames, goes inactive (guarded)
+  FlushInfo flush_latest;               // queued frames, as recorded (guarded)
+  std::atomic<uint64_t> flush_count{0}; // stamped on ingested packets
   std::atomic_bool ready{false};
   std::atomic_bool spool_frames{false};
-  std::shared_timed_mutex rack_mtx;
-  std::shared_timed_mutex wip_mtx;
   std::unique_ptr<Av> av;
+  std::atomic<uint64_t> pending_ct{CT_NONE}; // applied by the decode stage
+
+  // single producer (decode stage), single consumer (next_frame)
+  JitterBuffer racked;
 
-  racked_reels racked;
-  std::optional<Reel> wip;
-  frame_t first_frame;
+  // pipeline: ingest (handoff) -> decipher -> decode -> dsp (see Dsp) -> racked
+  std::mutex ingest_mtx; // sessions may briefly overlap
+  std::optional<Stage<deciphered_t, 512>> decode_stage;
+  std::optional<Stage<ingest_t, 1024>> decipher_stage;
 
 private:
   std::optional<std::latch> shutdown_latch;
-  static int64_t REEL_SERIAL_NUM; // ever incrementing, no dups
+
+  static constexpr uint64_t CT_NONE{std::numeric_limits<uint64_t>::max()};
 
 public:
-  static constexpr Nanos reel_max_wait{InputInfo::lead_time_min};
   static constexpr csv module_id{"desk.racked"};
 
 }; // Racked
@@ -29,6 +29,8 @@
 namespace pierre {
 
 class SilentFrame : public Frame {
+  friend class FramePool;
+
 private:
   SilentFrame() noexcept : Frame(frame::DSP_COMPLETE) {
 
@@ -54,7 +56,8 @@ private:
   }
 
 public:
-  static auto create() noexcept { return std::shared_ptr<SilentFrame>(new SilentFrame()); }
+  /// @brief Create a SilentFrame (recycled via the FramePool)
+  static frame_t create() noexcept;
 
   static void reset() noexcept {
     frame_num = 0;
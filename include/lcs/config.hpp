@@ -28,6 +28,8 @@
 
 #include <atomic>
 #include <filesystem>
+#include <forward_list>
+#include <functional>
 #include <future>
 #include <list>
 #include <optional>
@@ -193,4 +195,96 @@ inline bool cfg_info(csv mod, csv cat) noexcept {
   return Config::ready() ? shared::config->info_bool(mod, cat) : true;
 }
 
+/// @brief Base of typed config bindings.  Bindings are resolved when created and
+///        refreshed (all at once) when Config is initialized and each time
+///        monitor_file() detects the config file changed.
+class ConfigBinding {
+public:
+  virtual ~ConfigBinding() noexcept = default;
+
+  /// @brief Resolve every binding (called by Config)
+  static void refresh_all() noexcept;
+
+protected:
+  ConfigBinding() = default;
+
+  // derived classes bind once fully constructed and unbind before destruction
+  void bind() noexcept;
+  void unbind() noexcept;
+
+  virtual void refresh() noexcept = 0;
+};
+
+/// @brief Typed config value bound to a path (or resolver) for hot paths.  Reading
+///        the value is a single atomic load: relaxed for small trivially copyable
+///        types, acquire of a pointer to the latest resolved version otherwise.
+///        Resolved versions are kept for the lifetime of the binding so a reference
+///        returned by get() never dangles.
+template <typename T> class ConfigValue : public ConfigBinding {
+  static constexpr bool INLINE{std::is_trivially_copyable_v<T> && (sizeof(T) <= sizeof(void *))};
+
+public:
+  using resolver_t = std::function<T()>;
+
+public:
+  /// @brief Bind to a config path
+  /// @param path full path to the value
+  /// @param def_val value when not present (or config is not ready)
+  ConfigValue(toml::path path, T def_val) noexcept
+      : ConfigValue(path_resolver(std::move(path), def_val), def_val) {}
+
+  /// @brief Bind using a resolver (e.g. composite values built from several keys)
+  /// @param resolver returns the value, only called when config is ready
+  /// @param def_val value when config is not ready
+  ConfigValue(resolver_t resolver, T def_val) noexcept
+      : resolver(std::move(resolver)), def_val(std::move(def_val)) {
+    refresh();
+    bind();
+  }
+
+  ~ConfigValue() noexcept { unbind(); }
+
+  ConfigValue(const ConfigValue &) = delete;
+  ConfigValue &operator=(const ConfigValue &) = delete;
+
+  decltype(auto) get() const noexcept {
+    if constexpr (INLINE) {
+      return live.load(std::memory_order_relaxed);
+    } else {
+      return static_cast<const T &>(*live.load(std::memory_order_acquire));
+    }
+  }
+
+  decltype(auto) operator()() const noexcept { return get(); }
+
+protected:
+  void refresh() noexcept override {
+    T val = Config::ready() ? resolver() : def_val;
+
+    if constexpr (INLINE) {
+      live.store(val, std::memory_order_relaxed);
+    } else {
+      // refresh is serialized by refresh_all()
+      versions.emplace_front(std::move(val));
+      live.store(&versions.front(), std::memory_order_release);
+    }
+  }
+
+private:
+  static resolver_t path_resolver(toml::path path, T def_val) noexcept {
+    return [path = std::move(path), def_val = std::move(def_val)]() {
+      return shared::config->at(path).template value_or<T>(T(def_val));
+    };
+  }
+
+private:
+  // order dependent
+  resolver_t resolver;
+  T def_val;
+
+  // order independent
+  std::forward_list<T> versions; // unused when INLINE
+  std::atomic<std::conditional_t<INLINE, T, const T *>> live{};
+};
+
 } // namespace pierre
\ No newline at end of file
@@ -0,0 +1,113 @@
+//  Pierre - Custom Light Show for Wiss Landing
+//  Copyright (C) 2022  Tim Hughey
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//  https://www.wisslanding.com
+
+#pragma once
+
+#include "base/types.hpp"
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+namespace pierre {
+
+/// @brief HDR style log-linear histogram of non-negative integer values (e.g. nanos).
+///        Each power of two is split into SUB_COUNT linear buckets so the relative
+///        error of any reported value is at most 1 / SUB_COUNT (~3%).  Recording is
+///        a single relaxed fetch_add (safe from any thread); take() returns and
+///        resets the counts accumulated since the previous take().
+class Histogram {
+public:
+  static constexpr unsigned SUB_BITS{5};
+  static constexpr uint64_t SUB_COUNT{1u << SUB_BITS};
+  static constexpr unsigned MAX_BITS{40}; // ~1100s of nanos, larger values are clamped
+  static constexpr size_t BUCKETS{(MAX_BITS - SUB_BITS + 1) * SUB_COUNT};
+
+  struct summary {
+    uint64_t count{0};
+    uint64_t negative{0}; // values recorded below zero (counted as zero)
+    uint64_t p50{0};
+    uint64_t p90{0};
+    uint64_t p99{0};
+    uint64_t p999{0};
+    uint64_t max{0};
+  };
+
+public:
+  Histogram() = default;
+  Histogram(const Histogram &) = delete;
+  Histogram &operator=(const Histogram &) = delete;
+
+  void record(int64_t v) noexcept {
+    if (v < 0) [[unlikely]] {
+      negative.fetch_add(1, std::memory_order_relaxed);
+      v = 0;
+    }
+
+    const auto u = static_cast<uint64_t>(v);
+    counts[index(u)].fetch_add(1, std::memory_order_relaxed);
+
+    // max is rarely raised once an interval is underway
+    for (auto m = max.load(std::memory_order_relaxed); u > m;) {
+      if (max.compare_exchange_weak(m, u, std::memory_order_relaxed)) break;
+    }
+  }
+
+  /// @brief Summarize (and reset) the values recorded since the previous take()
+  summary take() noexcept; // see .cpp
+
+  /// @brief Bucket for a value
+  static constexpr size_t index(uint64_t v) noexcept {
+    if (v < SUB_COUNT) return v;
+
+    const unsigned msb = std::bit_width(v) - 1;
+    if (msb >= MAX_BITS) return BUCKETS - 1;
+
+    const unsigned shift = msb - SUB_BITS + 1;
+
+    return (shift * SUB_COUNT) + ((v >> (shift - 1)) - SUB_COUNT);
+  }
+
+  /// @brief Smallest value within a bucket
+  static constexpr uint64_t lowest(size_t idx) noexcept {
+    if (idx < SUB_COUNT) return idx;
+
+    const auto shift = idx / SUB_COUNT;
+
+    return ((idx % SUB_COUNT) + SUB_COUNT) << (shift - 1);
+  }
+
+  /// @brief Midpoint of a bucket (value reported for quantiles)
+  static constexpr uint64_t midpoint(size_t idx) noexcept {
+    if (idx < SUB_COUNT) return idx;
+
+    return lowest(idx) + ((uint64_t{1} << ((idx / SUB_COUNT) - 1)) / 2);
+  }
+
+private:
+  std::array<std::atomic<uint64_t>, BUCKETS> counts{};
+  std::atomic<uint64_t> negative{0};
+  std::atomic<uint64_t> max{0};
+
+public:
+  static constexpr csv module_id{"lcs.histogram"};
+};
+
+} // namespace pierre
@@ -0,0 +1,78 @@
+//  Pierre - Custom Light Show for Wiss Landing
+//  Copyright (C) 2022  Tim Hughey
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//  https://www.wisslanding.com
+
+#pragma once
+
+#include "base/types.hpp"
+#include "lcs/config.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace pierre {
+
+/// @brief The [info] table compiled to a (dotted path) -> bool hash table.
+///        Lookups hash the module id and category in place (no allocation)
+///        and never lock; the table is rebuilt when the config changes.
+class LogFilter {
+public:
+  LogFilter() = default; // empty filter, everything is logged
+
+  /// @brief Compile every boolean within the [info] table
+  /// @param info the [info] table
+  explicit LogFilter(const toml::table &info) noexcept;
+
+  /// @brief Same precedence as Config::info_bool():
+  ///        1. info.<cat>, 2. info.<mod>, 3. info.<mod>.<cat> (default true)
+  bool should_log(csv mod, csv cat) const noexcept;
+
+  size_t size() const noexcept { return count; }
+
+private:
+  struct entry {
+    uint64_t hash{0};
+    string path; // dotted path relative to [info]
+    bool val{true};
+  };
+
+  static constexpr uint64_t FNV_BASIS{0xcbf29ce484222325};
+  static constexpr uint64_t FNV_PRIME{0x100000001b3};
+
+  static constexpr uint64_t fnv(csv s, uint64_t h = FNV_BASIS) noexcept {
+    for (const auto c : s) {
+      h = (h ^ static_cast<uint8_t>(c)) * FNV_PRIME;
+    }
+
+    return h;
+  }
+
+  void add(string path, bool val) noexcept;
+  void flatten(const toml::table &table, const string &prefix) noexcept;
+
+  /// @brief Find the entry for a path made of one or two parts (joined by a dot)
+  const entry *find(uint64_t hash, csv a, csv b = csv()) const noexcept;
+
+private:
+  std::vector<entry> slots; // open addressing, power of two
+  size_t count{0};
+
+public:
+  static constexpr csv module_id{"log_filter"};
+};
+
+} // namespace pierre
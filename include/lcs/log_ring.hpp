@@ -0,0 +1,180 @@
+//  Pierre - Custom Light Show for Wiss Landing
+//  Copyright (C) 2022  Tim Hughey
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//  https://www.wisslanding.com
+
+#pragma once
+
+#include "base/types.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fmt/format.h>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace pierre {
+
+/// @brief Fixed size binary log record.  Arguments that are cheap and safe to
+///        copy (numbers, enums, durations) are captured as-is and formatted by
+///        the logger thread; everything else is formatted by the caller into
+///        the record (no allocation unless the message exceeds the record).
+struct alignas(64) log_record {
+private:
+  template <typename T> struct is_duration : std::false_type {};
+  template <typename R, typename P>
+  struct is_duration<std::chrono::duration<R, P>> : std::true_type {};
+
+public:
+  using render_fn = void (*)(fmt::string_view, const std::byte *, fmt::memory_buffer &);
+
+  static constexpr size_t ID_MAX{24};
+  static constexpr size_t PAYLOAD{144};
+
+  // order dependent
+  std::atomic<uint64_t> seq{0}; // ring sequence (see LogRing)
+  int64_t ts{0};                // nanos since logger start
+
+  // when render is set the payload holds captured args for fs
+  // otherwise the payload holds len bytes of formatted text (or spill)
+  render_fn render{nullptr};
+  fmt::string_view fs;
+  string *spill{nullptr}; // message larger than the payload (heap)
+  uint16_t len{0};
+  uint8_t mod_len{0};
+  uint8_t cat_len{0};
+  std::array<char, ID_MAX> mod;
+  std::array<char, ID_MAX> cat;
+  alignas(16) std::array<std::byte, PAYLOAD> payload;
+
+  csv mod_id() const noexcept { return csv(mod.data(), mod_len); }
+  csv category() const noexcept { return csv(cat.data(), cat_len); }
+  csv text() const noexcept {
+    return spill ? csv(*spill) : csv(reinterpret_cast<const char *>(payload.data()), len);
+  }
+
+  static void copy_id(csv id, std::array<char, ID_MAX> &dest, uint8_t &dest_len) noexcept {
+    dest_len = static_cast<uint8_t>(std::min(id.size(), ID_MAX));
+    std::copy_n(id.data(), dest_len, dest.data());
+  }
+
+  /// @brief Args the logger thread may safely format later (no pointers or views)
+  template <typename T>
+  static constexpr bool deferrable_v =
+      std::is_arithmetic_v<T> || std::is_enum_v<T> || is_duration<T>::value;
+
+  template <typename... A>
+  static constexpr bool deferrable_all_v =
+      (deferrable_v<std::remove_cvref_t<A>> && ...) &&
+      (sizeof(std::tuple<std::remove_cvref_t<A>...>) <= PAYLOAD) &&
+      (alignof(std::tuple<std::remove_cvref_t<A>...>) <= 16);
+
+  template <typename... A>
+  static void render_args(fmt::string_view fs, const std::byte *p, fmt::memory_buffer &buf) {
+    const auto &args = *std::launder(reinterpret_cast<const std::tuple<A...> *>(p));
+
+    std::apply(
+        [&](const auto &...a) {
+          fmt::vformat_to(fmt::appender(buf), fs, fmt::make_format_args(a...));
+        },
+        args);
+  }
+};
+
+static_assert(sizeof(log_record) == 256, "log_record should be exactly four cache lines");
+
+/// @brief Bounded lock-free ring of log records.  Any thread may claim() and
+///        publish() a record (multiple producers); only the logger thread calls
+///        front() and pop() (single consumer).  A full ring is reported to the
+///        producer (claim() returns nullptr) which counts the dropped message.
+class LogRing {
+public:
+  static constexpr size_t CAPACITY{4096}; // 1MiB, must be a power of two
+
+private:
+  static constexpr size_t MASK{CAPACITY - 1};
+  static_assert((CAPACITY & MASK) == 0, "CAPACITY must be a power of two");
+
+public:
+  LogRing() noexcept {
+    for (size_t i = 0; i < CAPACITY; i++) {
+      records[i].seq.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  LogRing(const LogRing &) = delete;
+  LogRing &operator=(const LogRing &) = delete;
+
+  /// @brief Producer: reserve the next record
+  /// @return record to populate then publish() or nullptr when the ring is full
+  log_record *claim() noexcept {
+    auto pos = enqueue_pos.load(std::memory_order_relaxed);
+
+    for (;;) {
+      auto &rec = records[pos & MASK];
+      const auto seq = rec.seq.load(std::memory_order_acquire);
+      const auto diff = static_cast<int64_t>(seq) - static_cast<int64_t>(pos);
+
+      if (diff == 0) {
+        if (enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          rec.render = nullptr;
+          rec.spill = nullptr;
+          return &rec;
+        }
+      } else if (diff < 0) {
+        return nullptr; // full, consumer has not caught up
+      } else {
+        pos = enqueue_pos.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  /// @brief Producer: make a claimed record visible to the consumer
+  static void publish(log_record *rec) noexcept {
+    // a claimed record's sequence is the position it was claimed at
+    rec->seq.store(rec->seq.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+  }
+
+  /// @brief Consumer: the oldest published record or nullptr
+  log_record *front() noexcept {
+    auto &rec = records[dequeue_pos & MASK];
+
+    return rec.seq.load(std::memory_order_acquire) == (dequeue_pos + 1) ? &rec : nullptr;
+  }
+
+  /// @brief Consumer: release the record returned by front() for reuse
+  void pop() noexcept {
+    auto &rec = records[dequeue_pos & MASK];
+
+    delete std::exchange(rec.spill, nullptr);
+    rec.seq.store(dequeue_pos + CAPACITY, std::memory_order_release);
+    dequeue_pos++;
+  }
+
+private:
+  std::array<log_record, CAPACITY> records;
+
+  alignas(64) std::atomic<uint64_t> enqueue_pos{0}; // producers
+  alignas(64) uint64_t dequeue_pos{0};              // consumer only
+};
+
+} // namespace pierre
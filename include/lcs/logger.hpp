@@ -18,8 +18,10 @@
 
 #pragma once
 
+#include "base/elapsed.hpp"
 #include "base/types.hpp"
 #include "io/io.hpp"
+#include "lcs/log_ring.hpp"
 
 #include <atomic>
 #include <chrono>
@@ -31,7 +33,10 @@
 #include <fmt/ostream.h>
 #include <fmt/std.h>
 #include <memory>
+#include <mutex>
 #include <optional>
+#include <tuple>
+#include <type_traits>
 
 namespace pierre {
 class Logger;
@@ -54,23 +59,48 @@ public:
   void info(const M &mod_id, const C &cat, const S &format, Args &&...args) {
 
     if (should_log(mod_id, cat)) {
+      const bool sync = shutting_down.load(std::memory_order_relaxed);
 
-      const auto prefix = fmt::format(prefix_format,      //
-                                      runtime(),          // millis since app start
-                                      width_ts,           // width of timsstap field,
-                                      width_ts_precision, // runtime + width and precision
-                                      mod_id, width_mod,  // module_id + width
-                                      cat, width_cat);    // category + width)
+      auto *rec = ring.claim();
 
-      const auto msg = fmt::vformat(format, fmt::make_format_args(args...));
+      if (!rec && sync) { // logger thread is gone, make room
+        drain();
+        rec = ring.claim();
+      }
+
+      if (!rec) [[unlikely]] {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+      }
+
+      // NOTE: everything below is captured, formatting is deferred to the logger thread
+      rec->ts = ((Nanos)elapsed_runtime).count();
+      log_record::copy_id(mod_id, rec->mod, rec->mod_len);
+      log_record::copy_id(cat, rec->cat, rec->cat_len);
+
+      const fmt::string_view fs = format;
 
-      if (shutting_down.load() == false) {
-        asio::post(io_ctx, [this, prefix = std::move(prefix), msg = std::move(msg)]() mutable {
-          print(std::move(prefix), std::move(msg));
-        });
+      if constexpr (log_record::deferrable_all_v<Args...>) {
+        using args_t = std::tuple<std::remove_cvref_t<Args>...>;
+
+        std::construct_at(reinterpret_cast<args_t *>(rec->payload.data()), args...);
+        rec->fs = fs;
+        rec->render = &log_record::render_args<std::remove_cvref_t<Args>...>;
       } else {
-        print(std::move(prefix), std::move(msg));
+        // args may reference caller owned data, format now (into the record)
+        auto *p = reinterpret_cast<char *>(rec->payload.data());
+        auto r = fmt::vformat_to_n(p, log_record::PAYLOAD, fs, fmt::make_format_args(args...));
+
+        if (r.size <= log_record::PAYLOAD) [[likely]] {
+          rec->len = r.size;
+        } else {
+          rec->spill = new string(fmt::vformat(fs, fmt::make_format_args(args...)));
+        }
       }
+
+      LogRing::publish(rec);
+
+      if (sync) drain();
     }
   }
 
@@ -85,7 +115,11 @@ public:
   static void startup() noexcept { shared::logger.startup_impl(); }
 
 private:
-  void print(const string prefix, const string msg) noexcept;
+  // consumer (logger thread or, once shut down, the calling thread)
+  void drain() noexcept;
+  void drain_timer_start() noexcept;
+  void format_prefix(Nanos ts, csv mod, csv cat) noexcept;
+  void write_batch() noexcept;
 
   void shutdown_impl() noexcept;
   void startup_impl() noexcept;
@@ -94,14 +128,29 @@ private:
   // order dependent
   io_context io_ctx;
   work_guard guard;
+  steady_timer drain_timer;
 
   // order independent
   std::atomic_bool shutting_down{false};
   std::optional<fmt::ostream> out;
 
+  // producers claim records, the consumer formats and writes them in batches
+  LogRing ring;
+  std::atomic<uint64_t> dropped{0};
+
+  // consumer only (serialized by drain_mtx)
+  std::mutex drain_mtx;
+  fmt::memory_buffer batch;
+  uint64_t dropped_reported{0};
+  size_t unflushed{0}; // bytes written since last flush
+  Elapsed since_flush;
+
 public:
   // order independent
   static constexpr csv SPACE{" "};
+  static constexpr auto DRAIN_INTERVAL{10ms};
+  static constexpr auto FLUSH_INTERVAL{100ms};
+  static constexpr size_t FLUSH_BYTES{16 * 1024};
   static constexpr fmt::string_view prefix_format{"{:>{}.{}} {:<{}} {:<{}}"};
   static constexpr int width_cat{15};
   static constexpr int width_mod{18};
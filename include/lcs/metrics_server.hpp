@@ -0,0 +1,62 @@
+//  Pierre - Custom Light Show for Wiss Landing
+//  Copyright (C) 2022  Tim Hughey
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//  https://www.wisslanding.com
+
+#pragma once
+
+#include "base/pet.hpp"
+#include "base/types.hpp"
+#include "io/io.hpp"
+
+#include <cstdint>
+#include <memory>
+
+namespace pierre {
+
+/// @brief Minimal HTTP/1.1 listener (localhost only) serving the most recent
+///        OpenMetrics snapshot at /metrics.  Runs on the Stats exporter io_context
+///        so the snapshot is replaced and served without locking; a scrape never
+///        reads the per thread accumulators.  A session (request and reply) that
+///        exceeds SESSION_TIMEOUT is closed so an idle client can not hold it.
+class MetricsServer {
+public:
+  MetricsServer(io_context &io_ctx, uint16_t port) noexcept;
+
+  /// @brief Replace the snapshot served to scrapes (exporter thread only)
+  void update(string &&text) noexcept {
+    snapshot = std::make_shared<const string>(std::move(text));
+  }
+
+private:
+  void async_accept() noexcept;
+  void session(std::shared_ptr<tcp_socket> sock) noexcept;
+
+private:
+  static constexpr Seconds SESSION_TIMEOUT{5};
+
+  // order dependent
+  io_context &io_ctx;
+  tcp_acceptor acceptor;
+
+  // order independent
+  std::shared_ptr<const string> snapshot{std::make_shared<const string>("# EOF\n")};
+
+public:
+  static constexpr csv module_id{"lcs.metrics"};
+};
+
+} // namespace pierre
@@ -22,90 +22,220 @@
 #include "base/pet.hpp"
 #include "base/types.hpp"
 #include "io/io.hpp"
+#include "lcs/histogram.hpp"
+#include "lcs/metrics_server.hpp"
 #include "lcs/stats_v.hpp"
+#include "lcs/thread_registry.hpp"
 
 #include <InfluxDBFactory.h>
+#include <array>
 #include <atomic>
 #include <chrono>
 #include <cmath>
+#include <cstdint>
+#include <limits>
 #include <map>
 #include <memory>
-#include <set>
-#include <tuple>
+#include <thread>
+#include <utility>
+#include <vector>
 
 namespace pierre {
 
-class Stats : public std::enable_shared_from_this<Stats> {
-private:
-  Stats(io_context &io_ctx, bool enabled = false) noexcept;
+namespace stats {
+
+/// @brief Interval accumulator for one stat (and tag) written by a single thread
+///        and read by the exporter.  Single writer so plain (relaxed) loads and
+///        stores suffice, no read-modify-write.
+struct cell {
+  std::atomic<uint64_t> count{0}; // cumulative, published last (release)
+  std::atomic<double> sum{0};     // cumulative
+  std::atomic<double> min{0};     // since epoch
+  std::atomic<double> max{0};     // since epoch
+  std::atomic<double> last{0};    // most recent sample (gauges)
+  std::atomic<uint32_t> epoch{0}; // export interval min/max belong to
+};
+
+/// @brief A thread's accumulators, acquired on the thread's first write from the
+///        slab registry and released (for reuse) when the thread exits.  Counts
+///        and sums are cumulative so the next thread simply continues them.
+struct slab {
+  static constexpr size_t TAGS{16}; // slot 0 is untagged
 
-  static auto ptr() noexcept { return self->shared_from_this(); }
+  std::array<std::array<cell, TAGS>, STATS_V_MAX> cells;
+};
+
+enum kind_t : uint8_t { UNSET = 0, NANOS, INTEGRAL, DOUBLE };
 
-  using stat_variant = std::variant<int32_t, int64_t, double>;
+// exporter snapshot of a slab's cumulative count and sum
+struct totals {
+  uint64_t count{0};
+  double sum{0};
+};
+
+using slab_totals = std::array<std::array<totals, slab::TAGS>, STATS_V_MAX>;
+
+} // namespace stats
+
+class Stats {
+private:
+  Stats(Millis interval) noexcept;
 
 public:
+  ~Stats() noexcept;
+
   // can safely be called multiple times
-  static const string init(io_context &io_ctx) noexcept; // see .cpp
+  static const string init() noexcept; // see .cpp
 
-  static void shutdown() noexcept { self.reset(); }
+  static void shutdown() noexcept;
 
+  /// @brief Accumulate a sample on the calling thread (exported at the next interval)
+  /// @param vt stat
+  /// @param v value (chrono duration, integral or convertible to double)
+  /// @param tag optional tag key/val, both must have static storage duration
   template <typename T>
   static void write(stats::stats_v vt, T v,
                     std::pair<const char *, const char *> tag = {nullptr, nullptr}) noexcept {
-    static constexpr csv DOUBLE{"double"};
-    static constexpr csv INTEGRAL{"integral"};
-    static constexpr csv MEASURE{"STATS"};
-    static constexpr csv METRIC{"metric"};
-    static constexpr csv NANOS{"nanos"};
-
-    if (self.use_count() < 1) return;
-
-    auto s = ptr(); // get a fresh shared_ptr (we'll move it into the lambda)
-
-    if (s->enabled.load()) {
-
-      // capture the time in the lambda so the point is most accurately recorded
-      auto pt = influxdb::Point(MEASURE.data()).addTag(METRIC.data(), s->val_txt[vt].data());
-
-      // now post the pt and params for eventual write to influx
-      auto &io_ctx = s->io_ctx; // get reference to io_ctx since we're moving s
-      asio::post(io_ctx, [s = std::move(s), v = std::move(v), pt = std::move(pt),
-                          tag = std::move(tag)]() mutable {
-        // this closure deliberately converts various types (e.g. chrono durations,
-        // Frequency, Magnitude) to the correct type for influx and sets the field key to
-        // an appropriate name to prevent different data types associated to the same key
-        // which violates influx design
-
-        if constexpr (IsDuration<T>) {
-          const auto d = std::chrono::duration_cast<Nanos>(v);
-          pt.addField(NANOS, d.count());
-        } else if constexpr (std::is_integral_v<T>) {
-          pt.addField(INTEGRAL, v);
-        } else if constexpr (std::is_convertible_v<T, double>) {
-          pt.addField(DOUBLE, v); // convert to double (e.g. Frequency, Magnitude)
-        } else {
-          static_assert(always_false_v<T>, "unhandled type");
-        }
-
-        if (tag.first && tag.second) {
-          pt.addTag(tag.first, tag.second);
-        }
-
-        s->db->write(std::move(pt));
-      });
+    if (!enabled.load(std::memory_order_acquire)) return;
+
+    // convert various types (e.g. chrono durations, Frequency, Magnitude) to a double
+    // and remember the influx field kind so the same key is never written with
+    // different data types which violates influx design
+    double x;
+    stats::kind_t kind;
+
+    if constexpr (IsDuration<T>) {
+      const auto d = std::chrono::duration_cast<Nanos>(v).count();
+
+      // timing stats also record their distribution (see Histogram)
+      if (auto *h = histograms[vt]; h) h->record(d);
+
+      x = d;
+      kind = stats::NANOS;
+    } else if constexpr (std::is_integral_v<T>) {
+      x = static_cast<double>(v);
+      kind = stats::INTEGRAL;
+    } else if constexpr (std::is_convertible_v<T, double>) {
+      x = static_cast<double>(v); // convert to double (e.g. Frequency, Magnitude)
+      kind = stats::DOUBLE;
+    } else {
+      static_assert(always_false_v<T>, "unhandled type");
     }
+
+    accumulate(vt, x, kind, tag);
   }
 
+private:
+  static void accumulate(stats::stats_v vt, double x, stats::kind_t kind,
+                         std::pair<const char *, const char *> tag) noexcept {
+    static thread_local const auto lease = register_slab();
+    auto *slab = lease.get();
+
+    const auto tag_id = tag.first && tag.second ? tag_slot(tag) : 0;
+
+    if (!slab || (tag_id < 0)) [[unlikely]] {
+      dropped.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+
+    if (kinds[vt].load(std::memory_order_relaxed) == stats::UNSET) {
+      kinds[vt].store(kind, std::memory_order_relaxed);
+    }
+
+    auto &c = slab->cells[vt][tag_id];
+    const auto e = epoch.load(std::memory_order_relaxed);
+    const auto n = c.count.load(std::memory_order_relaxed);
+
+    if (c.epoch.load(std::memory_order_relaxed) != e) { // first sample this interval
+      c.min.store(x, std::memory_order_relaxed);
+      c.max.store(x, std::memory_order_relaxed);
+      c.epoch.store(e, std::memory_order_relaxed);
+    } else {
+      if (x < c.min.load(std::memory_order_relaxed)) c.min.store(x, std::memory_order_relaxed);
+      if (x > c.max.load(std::memory_order_relaxed)) c.max.store(x, std::memory_order_relaxed);
+    }
+
+    c.sum.store(c.sum.load(std::memory_order_relaxed) + x, std::memory_order_relaxed);
+    c.last.store(x, std::memory_order_relaxed);
+    c.count.store(n + 1, std::memory_order_release);
+  }
+
+  using slab_registry = ThreadRegistry<stats::slab, 64>; // threads alive at once
+
+  static slab_registry &registry() noexcept; // see .cpp
+  static slab_registry::lease register_slab() noexcept;
+
+  /// @brief Intern a tag by pointer (tags are static strings)
+  /// @return tag slot or -1 when all slots are in use
+  static int tag_slot(std::pair<const char *, const char *> tag) noexcept {
+    for (size_t i = 1; i < stats::slab::TAGS; i++) {
+      auto &t = tags[i];
+      auto *key = t.key.load(std::memory_order_acquire);
+
+      if (key == nullptr) return claim_tag(tag);
+      if ((key == tag.first) && (t.val.load(std::memory_order_relaxed) == tag.second)) return i;
+    }
+
+    return -1;
+  }
+
+  static int claim_tag(std::pair<const char *, const char *> tag) noexcept; // see .cpp
+
+  struct interval_t {
+    uint64_t count{0};
+    double sum{0};
+    double min{std::numeric_limits<double>::max()};
+    double max{std::numeric_limits<double>::lowest()};
+  };
+
+  using interval_table = std::array<std::array<interval_t, stats::slab::TAGS>, stats::STATS_V_MAX>;
+  using gauge_table = std::array<std::array<double, stats::slab::TAGS>, stats::STATS_V_MAX>;
+  using histogram_table = std::array<Histogram::summary, stats::STATS_V_MAX>;
+
+  // exporter thread
+  void export_interval() noexcept;
+  void export_timer_start() noexcept;
+  void influx_write(const interval_table &agg, const histogram_table &hsum) noexcept;
+  string openmetrics(const histogram_table &hsum) noexcept;
+
+private:
+  struct tag_entry {
+    std::atomic<const char *> key{nullptr};
+    std::atomic<const char *> val{nullptr};
+  };
+
+  // shared by all writers (read mostly)
+  static std::atomic_bool enabled;
+  static std::atomic<uint32_t> epoch;
+  static std::array<std::atomic<stats::kind_t>, stats::STATS_V_MAX> kinds;
+  static std::array<tag_entry, stats::slab::TAGS> tags;
+  static std::array<Histogram *, stats::STATS_V_MAX> histograms; // set before enabled
+
+  // writes discarded (too many threads or tags)
+  static std::atomic<uint64_t> dropped;
+
+  static std::unique_ptr<Stats> self;
+
 private:
   // order dependent
-  io_context &io_ctx;
-  std::atomic_bool enabled{false};
+  io_context io_ctx;
+  steady_timer export_timer;
+  const Millis interval;
   std::map<stats::stats_v, string> val_txt;
 
   // order independent
-  static std::shared_ptr<Stats> self;
   std::unique_ptr<influxdb::InfluxDB> db;
-  std::set<std::shared_ptr<influxdb::Point>> points;
+  std::unique_ptr<MetricsServer> metrics; // optional OpenMetrics listener
+
+  // exporter only: cumulative count/sum at the previous export (per slab)
+  // and since start (all slabs)
+  std::vector<stats::slab_totals> prev;
+  stats::slab_totals cumulative{};
+  gauge_table gauges{}; // most recent sample of each gauge (and tag)
+  histogram_table hsum_last{};
+  uint64_t dropped_prev{0};
+
+  std::jthread thread; // last, joined before the members it uses are destroyed
 
 public:
   static constexpr csv module_id{"lcs.stats"};
@@ -19,10 +19,15 @@
 
 #pragma once
 
+#include <cstdint>
+
 namespace pierre {
 namespace stats {
 
-enum stats_v {
+enum stats_v : uint8_t {
+  CLOCK_DRIFT,
+  CLOCK_OFFSET,
+  CLOCK_RESIDUAL,
   CTRL_CONNECT_ELAPSED,
   CTRL_CONNECT_TIMEOUT,
   CTRL_MSG_READ_ELAPSED,
@@ -33,18 +38,24 @@ enum stats_v {
   DATA_CONNECT_FAILED,
   DATA_MSG_WRITE_ELAPSED,
   DATA_MSG_WRITE_ERROR,
+  DECODE_ELAPSED,
+  DMX_CONNECTED,
+  DSP_QUEUE_DEPTH,
+  DSP_SILENCE,
   FLUSH_ELAPSED,
   FPS,
   FRAME,
+  FRAME_POOL_HEAP,
+  FRAMES_FLUSHED,
   MAX_PEAK_FREQUENCY,
   MAX_PEAK_MAGNITUDE,
   NEXT_FRAME_WAIT,
   NO_CONN,
-  RACK_COLLISION,
-  RACK_WIP_INCOMPLETE,
-  RACK_WIP_TIMEOUT,
-  RACKED_REELS,
-  REELS_FLUSHED,
+  PIPELINE_DEPTH,
+  PIPELINE_DROPPED,
+  PIPELINE_LATENCY,
+  RACK_DROPPED,
+  RACKED_FRAMES,
   REMOTE_DATA_WAIT,
   REMOTE_DMX_QOK,
   REMOTE_DMX_QRF,
@@ -52,14 +63,17 @@ enum stats_v {
   REMOTE_ELAPSED,
   REMOTE_ROUNDTRIP,
   RENDER_ELAPSED,
+  RENDER_LATENESS,
   RTSP_SESSION_CONNECT,
   RTSP_SESSION_MSG_ELAPSED,
   RTSP_SESSION_RX_PACKET,
   RTSP_SESSION_TX_REPLY,
+  STATS_DROPPED,
   SYNC_WAIT,
   RTSP_AUDIO_CIPHERED,
   RTSP_AUDIO_DECIPERED,
   // extra comma allows for easy IDE sorting
+  STATS_V_MAX // must be last, not a stat (sizes per thread accumulators)
 };
 
 } // namespace stats
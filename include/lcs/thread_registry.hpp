@@ -0,0 +1,113 @@
+//  Pierre - Custom Light Show for Wiss Landing
+//  Copyright (C) 2022  Tim Hughey
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//  https://www.wisslanding.com
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+namespace pierre {
+
+/// @brief Bounded registry of per thread objects (e.g. Stats slabs, Trace rings).
+///        A thread acquires an object with its first write and holds it in a
+///        thread_local lease; the lease returns the object when the thread exits
+///        and a later thread reuses it.  Threads are recreated every session so
+///        MAX bounds the threads alive at once, not the threads ever created.
+///
+///        Objects are never freed so readers may walk [0, size()) without the
+///        lock; what an object holds when it changes hands is up to the caller
+///        (see acquire()).
+template <typename T, size_t MAX> class ThreadRegistry {
+public:
+  /// @brief A thread's object, released to the registry when destroyed
+  class lease {
+  public:
+    lease() = default;
+    lease(ThreadRegistry *reg, size_t idx) noexcept : reg(reg), idx(idx) {}
+    lease(lease &&rhs) noexcept : reg(std::exchange(rhs.reg, nullptr)), idx(rhs.idx) {}
+    lease(const lease &) = delete;
+    lease &operator=(const lease &) = delete;
+
+    ~lease() noexcept {
+      if (reg) reg->release(idx);
+    }
+
+    T *get() const noexcept { return reg ? reg->items[idx].get() : nullptr; }
+
+  private:
+    ThreadRegistry *reg{nullptr};
+    size_t idx{0};
+  };
+
+public:
+  ThreadRegistry() = default;
+
+  /// @brief Acquire a free object (reused or, below MAX, created)
+  /// @param prepare called with the object, its index and true when reused
+  ///        (holding the registry lock)
+  /// @return lease, empty when MAX objects are in use
+  template <typename F> lease acquire(F &&prepare) noexcept {
+    std::unique_lock lck(mtx);
+
+    const auto n = count.load(std::memory_order_relaxed);
+
+    for (size_t i = 0; i < n; i++) {
+      if (!in_use[i]) {
+        in_use[i] = true;
+        prepare(*items[i], i, true);
+        return lease(this, i);
+      }
+    }
+
+    if (n == MAX) return lease(); // the caller's thread goes without
+
+    items[n] = std::make_unique<T>();
+    in_use[n] = true;
+    prepare(*items[n], n, false);
+    count.store(n + 1, std::memory_order_release);
+
+    return lease(this, n);
+  }
+
+  /// @brief Objects ever created (in use or free)
+  size_t size() const noexcept { return count.load(std::memory_order_acquire); }
+
+  T &operator[](size_t i) const noexcept { return *items[i]; }
+
+  /// @brief Held by acquire() and release(), readers that must not see an
+  ///        object change hands (e.g. while copying its name) take it too
+  std::mutex &mutex() noexcept { return mtx; }
+
+private:
+  void release(size_t idx) noexcept {
+    std::unique_lock lck(mtx);
+    in_use[idx] = false;
+  }
+
+private:
+  std::mutex mtx;
+  std::array<std::unique_ptr<T>, MAX> items;
+  std::array<bool, MAX> in_use{}; // guarded by mtx
+  std::atomic<size_t> count{0};
+};
+
+} // namespace pierre
@@ -0,0 +1,148 @@
+//  Pierre - Custom Light Show for Wiss Landing
+//  Copyright (C) 2022  Tim Hughey
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//  https://www.wisslanding.com
+
+#pragma once
+
+#include "base/pet.hpp"
+#include "base/types.hpp"
+#include "lcs/thread_registry.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace pierre {
+
+namespace trace {
+
+// frame lifecycle stages, in pipeline order
+enum stage_t : uint8_t {
+  PACKET_READ = 0,
+  DECIPHER,
+  DECODE,
+  FFT_LEFT,
+  FFT_RIGHT,
+  FFT_STEREO, // joint stereo (both channels)
+  PEAKS,
+  RACKED,
+  DEQUEUED,
+  RENDERED,
+  DMX_WRITE,
+  STAGE_MAX // must be last, not a stage
+};
+
+/// @brief One traced stage (instant when dur is zero).  Fields are relaxed atomics
+///        so the dump may read a ring while its thread keeps writing.
+struct event {
+  std::atomic<int64_t> ts{0};    // monotonic nanos at stage start
+  std::atomic<int64_t> dur{0};   // nanos
+  std::atomic<uint64_t> meta{0}; // seq_num << 8 | stage
+};
+
+/// @brief Per thread ring of the most recent events (single writer).  Rings
+///        are released when their thread exits and reused by a later thread.
+struct ring {
+  static constexpr size_t CAPACITY{8192}; // must be a power of two
+  static constexpr size_t MASK{CAPACITY - 1};
+
+  std::array<event, CAPACITY> events;
+  std::atomic<uint64_t> head{0}; // total events written
+  uint64_t first{0};             // events before this belong to a previous thread
+  string thread_name;            // first and thread_name change under the registry lock
+
+  void add(stage_t stage, uint32_t seq_num, int64_t ts, int64_t dur) noexcept {
+    const auto h = head.load(std::memory_order_relaxed);
+    auto &e = events[h & MASK];
+
+    e.ts.store(ts, std::memory_order_relaxed);
+    e.dur.store(dur, std::memory_order_relaxed);
+    e.meta.store((uint64_t{seq_num} << 8) | stage, std::memory_order_relaxed);
+
+    head.store(h + 1, std::memory_order_release);
+  }
+};
+
+} // namespace trace
+
+/// @brief Per frame lifecycle tracing.  Each thread records stage timestamps
+///        into its own ring (no locks, no allocation after the first event);
+///        dump() writes the last few seconds as Chrome trace JSON (one track per
+///        thread).  When disabled recording is a single relaxed load.
+class Trace {
+public:
+  static void init() noexcept; // see .cpp
+
+  static bool enabled() noexcept { return active.load(std::memory_order_relaxed); }
+
+  /// @brief Record a point in time (e.g. frame racked)
+  static void instant(trace::stage_t stage, uint32_t seq_num) noexcept {
+    if (enabled()) record(stage, seq_num, pet::now_monotonic().count(), 0);
+  }
+
+  /// @brief Record a stage that started at start (see TraceSpan)
+  static void span(trace::stage_t stage, uint32_t seq_num, Nanos start) noexcept {
+    if (enabled()) {
+      const auto now = pet::now_monotonic();
+      record(stage, seq_num, start.count(), (now - start).count());
+    }
+  }
+
+  /// @brief Write events within the configured window as Chrome trace JSON
+  /// @return path written or a failure reason
+  static const string dump() noexcept;
+
+private:
+  static void record(trace::stage_t stage, uint32_t seq_num, int64_t ts, int64_t dur) noexcept {
+    static thread_local const auto lease = register_ring();
+
+    if (auto *ring = lease.get(); ring) ring->add(stage, seq_num, ts, dur);
+  }
+
+  using ring_registry = ThreadRegistry<trace::ring, 64>; // threads alive at once
+
+  static ring_registry &registry() noexcept; // see .cpp
+  static ring_registry::lease register_ring() noexcept;
+
+private:
+  static std::atomic_bool active;
+
+public:
+  static constexpr csv module_id{"lcs.trace"};
+};
+
+/// @brief Traces a stage from construction to destruction
+class TraceSpan {
+public:
+  TraceSpan(trace::stage_t stage, uint32_t seq_num) noexcept
+      : stage(stage), seq_num(seq_num),
+        start(Trace::enabled() ? pet::now_monotonic() : Nanos::zero()) {}
+
+  ~TraceSpan() noexcept {
+    if (start != Nanos::zero()) Trace::span(stage, seq_num, start);
+  }
+
+  TraceSpan(const TraceSpan &) = delete;
+  TraceSpan &operator=(const TraceSpan &) = delete;
+
+private:
+  const trace::stage_t stage;
+  const uint32_t seq_num;
+  const Nanos start;
+};
+
+} // namespace pierre
@@ -49,6 +49,11 @@ class Aes {
 public:
   Aes();
 
+  /// @brief Construct with an established shared secret (pairing is skipped)
+  ///        for replaying or benchmarking ciphered sessions
+  /// @param shared_secret result of a previous pair verify
+  Aes(const uint8v &shared_secret);
+
   ~Aes(); // no implict copy/move due to destructor definition
 
   /// @brief decrypt a chunk of data once pairing is complete otherwise passthrough
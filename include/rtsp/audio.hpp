@@ -24,38 +24,40 @@
 
 #include <memory>
 #include <optional>
+#include <thread>
 
 namespace pierre {
 namespace rtsp {
 
+/// @brief Audio (buffered) data connection.  Packets are read on a dedicated
+///        ingest thread (and io_context) that hands them to the frame pipeline
+///        (see Racked::handoff) so the RTSP control plane never competes with
+///        audio ingest.
 class Audio : public std::enable_shared_from_this<Audio> {
 
 public:
   Port port() noexcept { return acceptor.local_endpoint().port(); }
   std::shared_ptr<Audio> ptr() noexcept { return shared_from_this(); }
 
-  static auto start(io_context &io_ctx, std::shared_ptr<Ctx> rtsp_ctx) noexcept {
-    auto self = std::shared_ptr<Audio>(new Audio(io_ctx, rtsp_ctx));
+  static auto start(std::shared_ptr<Ctx> rtsp_ctx) noexcept {
+    auto self = std::shared_ptr<Audio>(new Audio(rtsp_ctx));
 
     self->async_accept();
 
+    // the ingest thread holds a reference until io_ctx runs out of work (teardown)
+    std::jthread([self]() { self->run(); }).detach();
+
     return self;
   }
 
-  void teardown() noexcept {
-    [[maybe_unused]] error_code ec;
-
-    acceptor.close(ec);
-    sock.close(ec);
-  }
+  void teardown() noexcept;
 
 private:
-  Audio(io_context &io_ctx, std::shared_ptr<Ctx> rtsp_ctx) noexcept
-      : io_ctx(io_ctx),                                                                        //
-        local_strand(io_ctx),                                                                  //
-        rtsp_ctx(rtsp_ctx),                                                                    //
-        acceptor{local_strand.context().get_executor(), tcp_endpoint{ip_tcp::v4(), ANY_PORT}}, //
-        sock(local_strand.context().get_executor())                                            //
+  Audio(std::shared_ptr<Ctx> rtsp_ctx) noexcept
+      : io_ctx(1),                                             // ingest thread only
+        rtsp_ctx(rtsp_ctx),                                    //
+        acceptor{io_ctx, tcp_endpoint{ip_tcp::v4(), ANY_PORT}}, //
+        sock(io_ctx)                                           //
   {}
 
   // asyncLoop is invoked to:
@@ -69,10 +71,11 @@ private:
 
   void async_read_packet() noexcept;
 
+  void run() noexcept; // ingest thread
+
 private:
   // order dependent
-  io_context &io_ctx;
-  strand local_strand;
+  io_context io_ctx;
   std::shared_ptr<Ctx> rtsp_ctx;
   tcp_acceptor acceptor;
   tcp_socket sock;
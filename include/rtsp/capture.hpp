@@ -0,0 +1,121 @@
+//  Pierre - Custom Light Show for Wiss Landing
+//  Copyright (C) 2022  Tim Hughey
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//  https://www.wisslanding.com
+
+#pragma once
+
+#include "base/pet.hpp"
+#include "base/types.hpp"
+#include "base/uint8v.hpp"
+#include "frame/clock_info.hpp"
+#include "frame/flush_info.hpp"
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace pierre {
+namespace rtsp {
+
+namespace capture {
+
+// file layout (all integers big endian):
+//
+//   header:  MAGIC (8 bytes) + capture start (u64, local monotonic ns)
+//   records: type (u8) + at (u64, ns since capture start) + len (u16) + payload
+//
+// packets are recorded as read from the audio socket (ciphered, without the
+// length prefix), the shared key only when it changes
+enum record_t : uint8_t {
+  PACKET = 1, // ciphered audio packet
+  KEY,        // shared key for the packets that follow
+  CLOCK,      // master clock when the anchor arrived (see clock_sample_t)
+  ANCHOR,     // SETRATEANCHORTIME (see anchor_t)
+  FLUSH,      // FLUSHBUFFERED (see flush_t)
+  TEARDOWN    // TEARDOWN (payload is one byte, 1 == full disconnect)
+};
+
+constexpr std::array<uint8_t, 8> MAGIC{'P', 'I', 'E', 'R', 'C', 'A', 'P', 1};
+
+struct clock_sample_t {
+  ClockID clock_id{0};
+  uint64_t sample_time{0}; // local time of the offset
+  uint64_t raw_offset{0};  // master clock time = local time + raw offset
+
+  uint8v encode() const noexcept;
+  static clock_sample_t decode(const uint8v &payload) noexcept;
+};
+
+struct anchor_t {
+  bool complete{false}; // all anchor keys present (otherwise the anchor is reset)
+  ClockID clock_id{0};
+  uint64_t secs{0};
+  uint64_t fracs{0};
+  uint64_t rtp_time{0};
+  uint64_t flags{0};
+  std::optional<bool> rate; // not always present
+
+  uint8v encode() const noexcept;
+  static anchor_t decode(const uint8v &payload) noexcept;
+};
+
+struct flush_t {
+  FlushInfo info;
+
+  uint8v encode() const noexcept;
+  static flush_t decode(const uint8v &payload) noexcept;
+};
+
+struct record {
+  record_t type;
+  Nanos at; // since capture start
+  uint8v payload;
+};
+
+using records = std::vector<record>;
+
+} // namespace capture
+
+/// @brief Records the buffered audio stream (as handed to Desk) and the RTSP
+///        messages that control it to a compact binary file for replay.
+///        Enabled via rtsp.capture.enable, the file (rtsp.capture.file) is
+///        truncated by the first record of each session and closed by a full
+///        TEARDOWN.  When disabled each call is a single relaxed load.
+class Capture {
+public:
+  static bool enabled() noexcept;
+
+  static void packet(const uint8v &packet, const uint8v &key) noexcept;
+  static void clock(const ClockInfo &clock) noexcept;
+  static void anchor(const capture::anchor_t &anchor) noexcept;
+  static void flush(const FlushInfo &info) noexcept;
+  static void teardown(bool disconnect) noexcept;
+
+  /// @brief Read an entire capture file
+  /// @param path file to read
+  /// @param start set to the capture start (local monotonic time)
+  /// @param err set to the reason when the file is not a capture or is truncated
+  /// @return records in capture order (those read before any error)
+  static capture::records load(const string &path, Nanos &start, string &err) noexcept;
+
+public:
+  static constexpr csv module_id{"rtsp.capture"};
+};
+
+} // namespace rtsp
+} // namespace pierre
@@ -32,6 +32,7 @@
 #include <exception>
 #include <functional>
 #include <memory>
+#include <mutex>
 #include <optional>
 
 namespace pierre {
@@ -98,6 +99,23 @@ public:
 
   void set_live() noexcept;
 
+  /// @brief Shared key (for decipher), the ingest thread takes a reference
+  ///        per packet so SETUP and TEARDOWN (RTSP threads) never change the
+  ///        key it is using
+  /// @return immutable key, empty before SETUP and after TEARDOWN
+  std::shared_ptr<const uint8v> shared_key() const noexcept {
+    std::lock_guard lck(shared_key_mtx);
+    return shared_key_ptr;
+  }
+
+  /// @brief Publish a new shared key (from SETUP, empty at TEARDOWN)
+  void shared_key(const uint8v &key) noexcept {
+    auto next = std::make_shared<const uint8v>(key);
+
+    std::lock_guard lck(shared_key_mtx);
+    shared_key_ptr.swap(next);
+  }
+
   void setup_stream(const auto timing_protocol) noexcept {
     if (timing_protocol == csv{"PTP"}) {
       stream_info.timing_cat = stream_info_t::cat::ptp_stream;
@@ -162,7 +180,6 @@ public:
 
   // from SETUP message
   bool group_contains_group_leader{false};
-  uint8v shared_key; // shared key (for decipher)
   stream_info_t stream_info;
   string group_id; // airplay group id
 
@@ -174,6 +191,9 @@ public:
 private:
   std::atomic_bool teardown_in_progress{false};
 
+  mutable std::mutex shared_key_mtx;
+  std::shared_ptr<const uint8v> shared_key_ptr{std::make_shared<const uint8v>()};
+
 public:
   static constexpr csv module_id{"rtsp.ctx"};
 };
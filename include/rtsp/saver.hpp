@@ -36,11 +36,6 @@ public:
   Saver(Saver::Direction direction, const Headers &headers, const uint8v &content,
         const RespCode resp_code = RespCode(RespCode::code_val::OK)) noexcept;
 
-private:
-  bool enable{false};
-  const string file;
-  const string format;
-
 public:
   string msg;
   static constexpr csv module_id{"rtsp.saver"};
@@ -0,0 +1,111 @@
+//  Pierre - Custom Light Show for Wiss Landing
+//  Copyright (C) 2022  Tim Hughey
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//  https://www.wisslanding.com
+
+#pragma once
+
+#include "base/pet.hpp"
+#include "base/types.hpp"
+#include "frame/clock_info.hpp"
+
+#define TOML_ENABLE_FORMATTERS 0 // don't need formatters
+#define TOML_HEADER_ONLY 0       // reduces compile times
+#include <toml++/toml.h>
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace pierre {
+namespace sim {
+
+/// @brief A change to the simulated master clock at a point in the script
+struct clock_event {
+  Nanos at{0};                     // since the script started
+  std::optional<ClockID> clock_id; // new master clock (mastership restarts)
+  Nanos master_for{0};             // new master clock has been master for
+  std::optional<int64_t> offset;   // absolute offset (ns)
+  std::optional<int64_t> step;     // offset step (ns)
+  std::optional<double> drift_ppm; // offset drift from here on
+  Nanos stale{0};                  // samples are not published for
+};
+
+/// @brief The simulated master clock at a point in the script
+struct clock_sample {
+  ClockID clock_id{0};
+  uint64_t offset{0};    // master clock time = local time + offset
+  Nanos master_start{0}; // since the script started (negative when before)
+  bool stale{false};     // nqptp has stopped publishing
+};
+
+/// @brief Scripted master clock (id changes, offset drift, steps and staleness).
+///        A sample is a pure function of the time since the script started so
+///        a script always produces the same clock.
+///
+///        scripts are toml:
+///
+///          interval_ms = 122  # publish interval (nqptp is ~122ms)
+///
+///          [[event]]
+///          at_ms = 0
+///          clock_id = "0x2f4a9c0b11d20001" # string (hex) or integer
+///          master_for_ms = 10_000          # so the clock starts out stable
+///          offset_ns = 1_500_000_000
+///          drift_ppm = 25.0
+///
+///          [[event]]
+///          at_ms = 20_000
+///          step_ns = -3_000_000
+///
+///          [[event]]
+///          at_ms = 30_000
+///          stale_ms = 2_000
+class ClockScript {
+public:
+  /// @brief A stable clock that never changes
+  ClockScript() noexcept;
+
+  /// @brief Script from a toml table (see above)
+  /// @throws std::runtime_error when an event is malformed
+  ClockScript(const toml::table &table);
+
+  /// @brief Add an event (events are kept in time order)
+  ClockScript &add(clock_event event) noexcept;
+
+  Nanos interval() const noexcept { return _interval; }
+
+  /// @brief The clock at a point in the script
+  /// @param at time since the script started
+  clock_sample sample(Nanos at) const noexcept;
+
+  /// @brief Convenience for benchmarks and tests, a ClockInfo as MasterClock
+  ///        would create from the published sample
+  /// @param at time since the script started
+  /// @param start local time the script started
+  ClockInfo clock_info(Nanos at, Nanos start) const noexcept;
+
+private:
+  Nanos _interval{Millis(122)};
+  std::vector<clock_event> events;
+
+public:
+  static constexpr ClockID CLOCK_ID{0x2f4a9c0b11d20001};
+  static constexpr csv module_id{"sim.clock_script"};
+};
+
+} // namespace sim
+} // namespace pierre
@@ -0,0 +1,63 @@
+//  Pierre - Custom Light Show for Wiss Landing
+//  Copyright (C) 2022  Tim Hughey
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//  https://www.wisslanding.com
+
+#pragma once
+
+#include "base/pet.hpp"
+#include "base/types.hpp"
+#include "frame/master_clock.hpp"
+
+#include <cstdint>
+
+namespace pierre {
+namespace sim {
+
+/// @brief Stand-in for nqptp: owns a shm segment in the nqptp (version 8)
+///        layout read by MasterClock.  The segment is created exclusively so
+///        a running nqptp is never overwritten and is unlinked on destruction.
+class Nqptp {
+public:
+  /// @brief Create and map the segment
+  /// @param shm_name segment name (see master_clock.shm_name)
+  /// @throws std::runtime_error when the segment exists or can not be mapped
+  Nqptp(const string &shm_name);
+  ~Nqptp() noexcept;
+
+  /// @brief Publish a clock sample (as nqptp does every ~122ms)
+  /// @param clock_id master clock id
+  /// @param local_time local time (CLOCK_MONOTONIC_RAW) of the sample
+  /// @param offset add to local time to get master clock time
+  /// @param master_start local time the clock became master
+  void publish(ClockID clock_id, Nanos local_time, uint64_t offset, Nanos master_start) noexcept;
+
+private:
+  const string shm_name;
+  MasterClock::nqptp *data{nullptr};
+
+public:
+  static constexpr csv module_id{"sim.nqptp"};
+
+public:
+  Nqptp(const Nqptp &) = delete;            // no copy
+  Nqptp(Nqptp &&) = delete;                 // no move
+  Nqptp &operator=(const Nqptp &) = delete; // no copy assignment
+  Nqptp &operator=(Nqptp &&) = delete;      // no move assignment
+};
+
+} // namespace sim
+} // namespace pierre
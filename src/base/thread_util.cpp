@@ -19,12 +19,22 @@
 #include "base/thread_util.hpp"
 
 #include <array>
+#include <cerrno>
+#include <ctime>
 #include <fmt/format.h>
 #include <iterator>
 #include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
 
 namespace pierre {
 
+namespace {
+thread_local string thread_name_full;
+}
+
+csv thread_util::name() noexcept { return thread_name_full; }
+
 const string thread_util::set_name(csv name, int num) noexcept {
   static constexpr csv prefix{"pierre"};
   const auto tid = pthread_self();
@@ -36,6 +46,8 @@ const string thread_util::set_name(csv name, int num) noexcept {
 
   if (num >= 0) fmt::format_to(w, "{}", num);
 
+  thread_name_full = thread_name;
+
   // name the avahi thread (if needed)
   std::array<char, 64> buff{0x00};
 
@@ -48,4 +60,53 @@ const string thread_util::set_name(csv name, int num) noexcept {
   return thread_name;
 }
 
+int thread_util::set_affinity(int cpu) noexcept {
+  cpu_set_t cpus;
+  CPU_ZERO(&cpus);
+  CPU_SET(cpu, &cpus);
+
+  return pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+}
+
+int thread_util::set_fifo(int priority) noexcept {
+  sched_param param{};
+  param.sched_priority = priority;
+
+  return pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+}
+
+int thread_util::lock_memory() noexcept {
+  return (mlockall(MCL_CURRENT | MCL_FUTURE) == 0) ? 0 : errno;
+}
+
+[[gnu::noinline]] void thread_util::prefault_stack() noexcept {
+  uint8_t stack[STACK_PREFAULT];
+  volatile uint8_t *page = stack; // volatile, the writes must not be elided
+
+  for (size_t i = 0; i < STACK_PREFAULT; i += 4096) {
+    page[i] = 0;
+  }
+}
+
+void thread_util::sleep_until(Nanos deadline) noexcept {
+  // pet::now_monotonic() is CLOCK_MONOTONIC_RAW which clock_nanosleep does not
+  // support, translate the deadline to CLOCK_MONOTONIC (the clocks differ only
+  // by NTP slewing, negligible across a frame).  the raw clock is read first
+  // so a preemption between the reads moves the wake later, never earlier
+  const auto wait = deadline - pet::now_monotonic();
+  if (wait <= Nanos::zero()) return;
+
+  timespec mono;
+  clock_gettime(CLOCK_MONOTONIC, &mono);
+
+  const auto at = Nanos(mono.tv_sec * pet::NS_FACTOR.count() + mono.tv_nsec) + wait;
+
+  timespec ts;
+  ts.tv_sec = at.count() / pet::NS_FACTOR.count();
+  ts.tv_nsec = at.count() % pet::NS_FACTOR.count();
+
+  while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR) {
+  }
+}
+
 } // namespace pierre
\ No newline at end of file
@@ -30,8 +30,10 @@
 #include "lcs/config.hpp"
 #include "lcs/logger.hpp"
 #include "lcs/stats.hpp"
+#include "lcs/trace.hpp"
 #include "mdns/mdns.hpp"
 
+#include <cstring>
 #include <exception>
 #include <functional>
 #include <future>
@@ -142,6 +144,8 @@ void Desk::frame_loop() noexcept {
 
     // render this frame and send to DMX controller
     if (frame->state.ready()) {
+      Elapsed render_elapsed;
+      TraceSpan span(trace::RENDERED, frame->seq_num);
       DmxDataMsg msg(frame, InputInfo::lead_time);
 
       if (fx_finished = active_fx->render(frame, msg); fx_finished == false) {
@@ -154,31 +158,42 @@ void Desk::frame_loop() noexcept {
           asio::post(io_ctx, std::bind(&DmxCtrl::run, dmx_ctrl.get()));
         }
       }
+
+      Stats::write(stats::RENDER_ELAPSED, render_elapsed.freeze());
     }
 
     if (!loop_active) break;
 
     // account for processing time thus far
     sync_wait = frame->sync_wait_recalc();
+    const auto present_at = pet::now_monotonic() + sync_wait;
 
     // notates rendered or silence in timeseries db
     frame->mark_rendered();
 
     if (sync_wait >= Nanos::zero() && loop_active) {
       // now we need to wait for the correct time to render the next frame
-      frame_timer.expires_after(sync_wait);
-      auto timer_fut = frame_timer.async_wait(asio::use_future);
-
-      try {
-        while (true) {
-          if (!timer_fut.valid() || !loop_active) throw std::runtime_error("invalid future");
-          auto fut_status = timer_fut.wait_for(InputInfo::lead_time_min);
-          if (fut_status == std::future_status::ready) break;
+      if (render_rt) {
+        thread_util::sleep_until(present_at);
+
+      } else {
+        frame_timer.expires_after(sync_wait);
+        auto timer_fut = frame_timer.async_wait(asio::use_future);
+
+        try {
+          while (true) {
+            if (!timer_fut.valid() || !loop_active) throw std::runtime_error("invalid future");
+            auto fut_status = timer_fut.wait_for(InputInfo::lead_time_min);
+            if (fut_status == std::future_status::ready) break;
+          }
+        } catch (const std::exception &err) {
+          INFO_AUTO("timer_fut exception {}\n", err.what());
+          loop_active = false;
         }
-      } catch (const std::exception &err) {
-        INFO_AUTO("timer_fut exception {}\n", err.what());
-        loop_active = false;
       }
+
+      // wake up lateness (relative to when the frame is to be presented)
+      Stats::write(stats::RENDER_LATENESS, pet::now_monotonic() - present_at);
     }
   } // while loop
 
@@ -187,6 +202,36 @@ void Desk::frame_loop() noexcept {
 
 void Desk::frame_timer_cancel() noexcept {}
 
+void Desk::render_loop() noexcept {
+  static constexpr csv fn_id{"render_loop"};
+  const auto thread_name = thread_util::set_name("render");
+
+  // real-time settings are best effort (e.g. SCHED_FIFO requires CAP_SYS_NICE)
+  if (const auto cpu = config_val2<Desk, int>("render.cpu", -1); cpu >= 0) {
+    if (const auto rc = thread_util::set_affinity(cpu); rc) {
+      INFO_AUTO("cpu={} affinity failed, {}\n", cpu, std::strerror(rc));
+    }
+  }
+
+  if (const auto priority = config_val2<Desk, int>("render.priority", 0); priority > 0) {
+    if (const auto rc = thread_util::set_fifo(priority); rc) {
+      INFO_AUTO("SCHED_FIFO priority={} failed, {}\n", priority, std::strerror(rc));
+    }
+  }
+
+  if (config_val2<Desk, bool>("render.mlock", false)) {
+    if (const auto rc = thread_util::lock_memory(); rc) {
+      INFO_AUTO("mlockall failed, {}\n", std::strerror(rc));
+    }
+  }
+
+  thread_util::prefault_stack();
+
+  INFO_THREAD_START();
+  frame_loop();
+  INFO_THREAD_STOP();
+}
+
 void Desk::resume() noexcept {
   static constexpr csv fn_id{"resume"};
 
@@ -201,12 +246,14 @@ void Desk::resume() noexcept {
   // once per app run
   if (io_ctx.stopped()) io_ctx.restart();
 
-  INFO_AUTO("requested, thread_count={}\n", thread_count);
+  render_rt = config_val2<Desk, bool>("render.rt", false);
+
+  INFO_AUTO("requested, thread_count={} render_rt={}\n", thread_count, render_rt);
 
   shutdown_latch = std::make_shared<std::latch>(thread_count);
 
   // once io_ctx is running (by starting threads) kick off frame_loop
-  asio::post(io_ctx, std::bind(&Desk::frame_loop, this));
+  if (!render_rt) asio::post(io_ctx, std::bind(&Desk::frame_loop, this));
 
   // note: work guard created in constructor
   for (auto n = 0; n < thread_count; n++) {
@@ -222,6 +269,13 @@ void Desk::resume() noexcept {
     }).detach();
   }
 
+  if (render_rt) {
+    // a previous render thread (stopped by standby()) has finished
+    if (render_thread.joinable()) render_thread.join();
+
+    render_thread = std::jthread(&Desk::render_loop, this);
+  }
+
   // all threads / strands are running, fire up subsystems
   INFO_AUTO("complete, threads={}\n", thread_count);
 }
@@ -253,6 +307,12 @@ void Desk::standby() noexcept {
   } catch (...) {
   }
 
+  // the render thread wakes by the next frame deadline and sees loop_active
+  // (unless standby() was called by frame_loop on the render thread)
+  if (render_thread.joinable() && (render_thread.get_id() != std::this_thread::get_id())) {
+    render_thread.join();
+  }
+
   // shutdown supporting subsystems
   dmx_ctrl.reset();
   active_fx.reset();
@@ -23,6 +23,7 @@
 #include "lcs/config.hpp"
 #include "lcs/logger.hpp"
 #include "lcs/stats.hpp"
+#include "lcs/trace.hpp"
 #include "mdns/mdns.hpp"
 #include "msg.hpp"
 
@@ -227,16 +228,22 @@ void DmxCtrl::send_ctrl_msg(desk::Msg msg) noexcept {
 }
 
 void DmxCtrl::send_data_msg(DmxDataMsg msg) noexcept {
+  Stats::write(stats::DMX_CONNECTED, connected.load());
+
   if (connected) { // only send msgs when connected
 
     msg.finalize();
 
+    const auto seq_num = msg.seq_num;
+    const auto trace_start = Trace::enabled() ? pet::now_monotonic() : Nanos::zero();
+
     desk::async_write_msg( //
         *data_sock,        //
-        std::move(msg), [this, e = Elapsed()](const error_code ec) mutable {
+        std::move(msg), [=, this, e = Elapsed()](const error_code ec) mutable {
           // better readability
 
           Stats::write(stats::DATA_MSG_WRITE_ELAPSED, e.freeze());
+          if (trace_start > Nanos::zero()) Trace::span(trace::DMX_WRITE, seq_num, trace_start);
 
           if (ec != errc::success) {
             Stats::write(stats::DATA_MSG_WRITE_ERROR, true);
@@ -102,7 +102,7 @@ void MajorPeak::handle_el_wire(Peaks &peaks) {
     if (const auto &peak = peaks.major_peak(); peak.useable()) {
 
       const duty_val_t x = _freq_limits.scaled_soft(). //
-                           interpolate(elwire->minMaxDuty<double>(), peak.frequency().scaled());
+                           interpolate(elwire->minMaxDuty<double>(), peak.frequency_scaled());
 
       elwire->fixed(x);
     } else {
@@ -332,18 +332,18 @@ const Color MajorPeak::make_color(const Peak &peak, const Color &ref) noexcept {
 
   } else if (peak.frequency() < _freq_limits.soft().min()) {
     // frequency less than the soft
-    color.setBrightness(_mag_limits, peak.magnitude().scaled());
+    color.setBrightness(_mag_limits, peak.magnitude_scaled());
 
   } else if (peak.frequency() > _freq_limits.soft().max()) {
     auto const &hue_cfg = _hue_cfg_map.at("above_soft_ceiling");
 
     auto fl_custom = freq_min_max(_freq_limits.soft().max(), _freq_limits.hard().max());
     auto hue_minmax = hue_cfg.hue_minmax();
-    auto degrees = fl_custom.interpolate(hue_minmax, peak.frequency().scaled()) * hue_cfg.hue.step;
+    auto degrees = fl_custom.interpolate(hue_minmax, peak.frequency_scaled()) * hue_cfg.hue.step;
 
     color.rotateHue(degrees);
     if (hue_cfg.brightness.mag_scaled) {
-      color.setBrightness(_mag_limits, peak.magnitude().scaled());
+      color.setBrightness(_mag_limits, peak.magnitude_scaled());
     } else {
       color.setBrightness(hue_cfg.brightness.max);
     }
@@ -354,10 +354,10 @@ const Color MajorPeak::make_color(const Peak &peak, const Color &ref) noexcept {
     const auto fl_soft = _freq_limits.scaled_soft();
     const auto hue_min_max = hue_cfg.hue_minmax();
 
-    auto degrees = fl_soft.interpolate(hue_min_max, peak.frequency().scaled()) * hue_cfg.hue.step;
+    auto degrees = fl_soft.interpolate(hue_min_max, peak.frequency_scaled()) * hue_cfg.hue.step;
 
     color.rotateHue(degrees);
-    color.setBrightness(_mag_limits, peak.magnitude().scaled());
+    color.setBrightness(_mag_limits, peak.magnitude_scaled());
   }
 
   return color;
@@ -31,8 +31,10 @@
 #include <exception>
 #include <fmt/format.h>
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <ranges>
+#include <thread>
 #include <vector>
 
 namespace pierre {
@@ -42,9 +44,11 @@ std::optional<Anchor> anchor;
 } // namespace shared
 
 // destructor, singleton static functions
-void Anchor::init() { shared::anchor.emplace(); }
+Anchor::Anchor() noexcept
+    : source_latest(&sources[0]) // no source anchor
+{}
 
-// general API and member functions
+void Anchor::init() { shared::anchor.emplace(); }
 
 AnchorLast Anchor::get_data(const ClockInfo &clock) noexcept {
   return shared::anchor->get_data_impl(clock);
@@ -52,12 +56,23 @@ AnchorLast Anchor::get_data(const ClockInfo &clock) noexcept {
 
 AnchorLast Anchor::get_data_impl(const ClockInfo &clock) noexcept {
 
+  // every MasterClock sample feeds the filter (even without an anchor) so the
+  // offset is smoothed by the time a session starts
+  const auto sampled = clock_filter.add(clock);
+
+  // nothing changed since the previous call, AnchorLast is still current
+  // (it accounts for the drift since it was derived)
+  if (!source_pickup() && !sampled) return last;
+
   // must have source anchor data to calculate last
-  if (source.has_value()) {
+  if (source.has_value() && clock_filter.ready()) {
+    const auto now = pet::now_monotonic();
+    const auto offset = clock_filter.offset_at(now);
 
     if (source->match_clock_id(clock)) {
       // master clock hasn't changed, just update AnchorLast
-      last.update(*source, clock);
+      last.update(*source, clock, offset, clock_filter.drift(), now);
+      last.generation = ++generation;
 
     } else if (last.age_check(5s)) {
       // master clock has changed relative to anchor
@@ -70,38 +85,131 @@ AnchorLast Anchor::get_data_impl(const ClockInfo &clock) noexcept {
       // to handle the master clock change, if it is stable, we update the source
       // anchor by applying it's offset to the the last localized time
       source->clock_id = clock.clock_id;
-      source->anchor_time = pet::apply_offset(last.localized, clock.rawOffset);
+      source->anchor_time = pet::apply_offset(last.localized, offset);
     }
   }
 
+  share();
+
   return last;
 }
 
-void Anchor::reset() noexcept {
-  shared::anchor->source.reset();
-  shared::anchor->last.reset();
+AnchorLast Anchor::latest() noexcept { // static
+  AnchorLast al;
+
+  if (!shared::anchor.has_value()) return al; // Anchor not initialized (e.g. bench)
+
+  const auto &self = shared::anchor.value();
+
+  for (;;) {
+    const auto seq = self.shared_seq.load(std::memory_order_acquire);
+
+    if ((seq & 1) == 0) {
+      al.clock_id = self.shared_clock_id.load(std::memory_order_relaxed);
+      al.rtp_time = self.shared_rtp_time.load(std::memory_order_relaxed);
+      al.localized = Nanos(self.shared_localized.load(std::memory_order_relaxed));
+      al.updated_at = Nanos(self.shared_updated_at.load(std::memory_order_relaxed));
+      al.drift = self.shared_drift.load(std::memory_order_relaxed);
+
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (self.shared_seq.load(std::memory_order_relaxed) == seq) return al;
+    }
+
+    std::this_thread::yield(); // get_data() is sharing
+  }
+}
+
+void Anchor::publish(source_t &&next) noexcept {
+  const auto *latest = source_latest.load(std::memory_order_relaxed);
+  const auto *reading = source_reading.load(std::memory_order_seq_cst);
+
+  auto *slot = &sources[++source_next % SLOTS];
+  while ((slot == latest) || (slot == reading)) {
+    slot = &sources[++source_next % SLOTS];
+  }
+
+  *slot = std::move(next);
+  source_latest.store(slot, std::memory_order_seq_cst);
+}
+
+void Anchor::share() noexcept {
+  const auto seq = shared_seq.load(std::memory_order_relaxed);
+
+  shared_seq.store(seq + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  shared_clock_id.store(last.clock_id, std::memory_order_relaxed);
+  shared_rtp_time.store(last.rtp_time, std::memory_order_relaxed);
+  shared_localized.store(last.localized.count(), std::memory_order_relaxed);
+  shared_updated_at.store(last.updated_at.count(), std::memory_order_relaxed);
+  shared_drift.store(last.drift, std::memory_order_relaxed);
+
+  shared_seq.store(seq + 2, std::memory_order_release);
+}
+
+void Anchor::reset() noexcept { // static
+  auto &self = shared::anchor.value();
+  std::unique_lock lck(self.source_mtx);
+
+  source_t next;
+  next.generation = self.source_latest.load(std::memory_order_relaxed)->generation + 1;
+  next.reset_last = true;
+
+  self.publish(std::move(next));
 }
 
 void Anchor::save(AnchorData ad) noexcept { // static
+  auto &self = shared::anchor.value();
+  std::unique_lock lck(self.source_mtx);
+
+  // writers are serialized, the latest source is stable while the lock is held
+  const auto &latest = *self.source_latest.load(std::memory_order_relaxed);
+
+  source_t next;
+  next.generation = latest.generation + 1;
 
-  if (shared::anchor->source.has_value()) {
-    auto &source = shared::anchor->source.value();
-    auto &last = shared::anchor->last;
+  if (latest.data.has_value()) {
+    const auto &source = latest.data.value();
 
     source.log_timing_change(ad);
 
-    if (source.match_clock_id(ad) &&
-        ((source.rtp_time != ad.rtp_time) || (source.anchor_time != ad.anchor_time))) {
+    next.params_change = source.match_clock_id(ad) && ((source.rtp_time != ad.rtp_time) ||
+                                                       (source.anchor_time != ad.anchor_time));
+  }
+
+  next.data.emplace(ad);
+  self.publish(std::move(next));
+}
 
-      if (!last.age_check(5s)) {
-        INFO(module_id, "WARN", "parameters have changed before clock={:#x} stablized\n",
-             ad.clock_id);
-        last.reset();
-      }
+bool Anchor::source_pickup() noexcept {
+  // announce the slot about to be read, publish() won't reuse it.  the announced
+  // slot must still be the latest after announcing or a writer may have missed it
+  const source_t *src = source_latest.load(std::memory_order_seq_cst);
+  source_reading.store(src, std::memory_order_seq_cst);
+
+  while (src != source_latest.load(std::memory_order_seq_cst)) {
+    src = source_latest.load(std::memory_order_seq_cst);
+    source_reading.store(src, std::memory_order_seq_cst);
+  }
+
+  const auto picked = src->generation != source_generation;
+
+  if (picked) {
+    source_generation = src->generation;
+    source = src->data;
+
+    if (src->reset_last) {
+      last.reset();
+    } else if (src->params_change && !last.age_check(5s)) {
+      INFO(module_id, "WARN", "parameters have changed before clock={:#x} stablized\n",
+           source->clock_id);
+      last.reset();
     }
   }
 
-  shared::anchor->source.emplace(ad);
+  source_reading.store(nullptr, std::memory_order_release);
+
+  return picked;
 }
 
 } // namespace pierre
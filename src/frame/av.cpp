@@ -17,33 +17,54 @@
 //  https://www.wisslanding.com
 
 #include "av.hpp"
+#include "base/elapsed.hpp"
+#include "lcs/config.hpp"
+#include "lcs/stats.hpp"
+#include "lcs/trace.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <utility>
 
 namespace pierre {
 
 Av::Av(io_context &io_ctx) noexcept : ready{false} {
 
+  // rms (dBFS) of the quietest frame worth an FFT, the default is far below
+  // the level where peaks reach the magnitude floor (frame.peaks.magnitudes)
+  const auto dbfs = config_val2<Av, double>("silence.dbfs", -70.0);
+  silence_mean_sq = std::pow(10.0, dbfs / 10.0);
+  silence_bytes = config_val2<Av, int64_t>("silence.max_bytes", 0);
+
+  // decimate ahead of the FFT, a smaller FFT covers the band below the
+  // decimated nyquist at the same bin spacing
+  if (const auto factor = config_val2<Dsp, int64_t>("decimate", 1); factor > 1) {
+    if ((factor == 2) || (factor == 4)) {
+      decimators.assign(2, Decimator(factor));
+    } else {
+      INFO_INIT("decimate={} unsupported (1, 2 or 4), not decimating\n", factor);
+    }
+  }
+
+  INFO_INIT("silence dbfs={:0.1f} max_bytes={} decimate={}\n", dbfs, silence_bytes,
+            decimators.empty() ? 1 : decimators.front().factor());
+
   dsp.emplace(); // fire up the DSP threads
 
   asio::post(io_ctx, [this]() {
     codec = avcodec_find_decoder(AV_CODEC_ID_AAC);
-
-    if (codec) {
-      codec_ctx = avcodec_alloc_context3(codec);
-
-      if (codec_ctx) {
-        if (auto rc = avcodec_open2(codec_ctx, codec, nullptr); rc < 0) {
-          INFO(module_id, "CODEC_OPEN", "failed, rc={}\n", rc);
-        } else [[likely]] {
-          parser_ctx = av_parser_init(codec->id);
-
-          if (parser_ctx) {
-            ready.store(true);
-          } else {
-            INFO(module_id, "init", "failed to initialize AV functions\n");
-          }
-        } // end parser ctx
-      }   // end open ctx
-    }     // end codec ctx
+    pkt = av_packet_alloc();
+    audio_frame = av_frame_alloc();
+
+    if (codec && pkt && audio_frame) {
+      // raw access units unless the decoder refuses the AudioSpecificConfig
+      if (open(RAW) || open(ADTS)) {
+        ready.store(true);
+      }
+    } else {
+      INFO(module_id, "init", "failed to initialize AV functions\n");
+    }
   });
 }
 
@@ -52,15 +73,46 @@ Av::~Av() noexcept {
 
   av_parser_close(parser_ctx);
   avcodec_free_context(&codec_ctx);
+  av_frame_free(&audio_frame);
+  av_packet_free(&pkt);
+}
+
+void Av::configure(uint64_t ct) noexcept {
+  static constexpr csv fn_id{"configure"};
+
+  if (!ready.load()) return; // decoder opens with the raw path
+
+  // a new stream, the filter history belongs to the previous one
+  for (auto &d : decimators) {
+    d.reset();
+  }
+
+  // as does proof the raw path works
+  raw_decoded = false;
+
+  if (ct == CT_AAC_LC) {
+    if (path != RAW) open(RAW);
+  } else {
+    INFO_AUTO("compression type={} is not AAC LC, decoding will fail\n", ct);
+  }
 }
 
-bool Av::decode_failed(const frame_t &frame, AVPacket **pkt, AVFrame **audio_frame) noexcept {
-  if (pkt) av_packet_free(pkt);
-  if (audio_frame) av_frame_free(audio_frame);
+bool Av::decode_failed(const frame_t &frame) noexcept {
+  static constexpr csv fn_id{"decode_failed"};
+
+  av_packet_unref(pkt);
+  av_frame_unref(audio_frame);
 
   frame->state = frame::DECODE_FAILURE;
   frame->state.record_state();
 
+  // fall back only when raw access units never decoded in this stream, once
+  // they have failures are bad frames (e.g. loss), not the wrong path
+  if (ready.load() && (path == RAW) && !raw_decoded && (++raw_failures >= RAW_FAILURES_MAX)) {
+    INFO_AUTO("raw access units failed {} times, falling back to ADTS\n", raw_failures);
+    open(ADTS);
+  }
+
   return false;
 }
 
@@ -77,30 +129,77 @@ void Av::log_diag_info(AVFrame *audio_frame) noexcept {
   }
 }
 
-void Av::log_discard(frame_t frame, int used) noexcept {
-  int32_t enc_size = std::ssize(frame->m.value()) + ADTS_HEADER_SIZE;
-
+void Av::log_discard(frame_t frame, int used, int encoded_size) noexcept {
   string msg;
   auto w = std::back_inserter(msg);
 
-  if ((used < 0) || (used != enc_size)) {
+  if ((used < 0) || (used != encoded_size)) {
     frame->state = frame::PARSE_FAILURE;
 
-    fmt::format_to(w, "used={:<6} size={:<6} diff={:+6}", used, enc_size, enc_size - used);
+    fmt::format_to(w, "used={:<6} size={:<6} diff={:+6}", used, encoded_size, encoded_size - used);
   }
 
   INFO(module_id, "DISCARD", "{} {}", frame->state, msg);
 }
 
-bool Av::parse(frame_t frame) noexcept {
+bool Av::silent(const frame_t &frame, const float *left, const float *right,
+                int samples) const noexcept {
+  // AAC encodes digital silence in a handful of bytes
+  if ((silence_bytes > 0) && (std::ssize(frame->m) <= silence_bytes)) return true;
 
-  auto rc = false;
-  auto pkt = av_packet_alloc();
+  if (samples <= 0) return false;
+
+  // energy of each channel, a frame is silent only when both are below the floor
+  float left_sq{0}, right_sq{0};
 
-  if (!pkt) return decode_failed(frame, &pkt);
+  for (int i = 0; i < samples; i++) {
+    left_sq += left[i] * left[i];
+    right_sq += right[i] * right[i];
+  }
 
-  auto m = frame->m->data();
-  const size_t encoded_size = std::size(frame->m.value());
+  return (std::max(left_sq, right_sq) / samples) < silence_mean_sq;
+}
+
+bool Av::open(decode_path want) noexcept {
+  static constexpr csv fn_id{"open"};
+
+  avcodec_free_context(&codec_ctx);
+
+  codec_ctx = avcodec_alloc_context3(codec);
+  if (!codec_ctx) return false;
+
+  if (want == RAW) {
+    // extradata is owned (and freed) by the codec context, must be padded
+    auto *extradata = static_cast<uint8_t *>(av_mallocz(ASC.size() + AV_INPUT_BUFFER_PADDING_SIZE));
+    if (!extradata) return false;
+
+    std::copy(ASC.begin(), ASC.end(), extradata);
+    codec_ctx->extradata = extradata;
+    codec_ctx->extradata_size = std::ssize(ASC);
+
+  } else if (!parser_ctx) {
+    parser_ctx = av_parser_init(codec->id);
+    if (!parser_ctx) return false;
+  }
+
+  if (auto rc = avcodec_open2(codec_ctx, codec, nullptr); rc < 0) {
+    INFO_AUTO("path={} failed, rc={}\n", want == RAW ? "raw" : "adts", rc);
+    return false;
+  }
+
+  path = want;
+  raw_failures = 0;
+
+  INFO_AUTO("path={}\n", path == RAW ? "raw" : "adts");
+
+  return true;
+}
+
+bool Av::adts_packet(const frame_t &frame) noexcept {
+  const int encoded_size = std::ssize(frame->m) + ADTS_HEADER_SIZE;
+
+  adts_buff.resize(encoded_size);
+  auto m = adts_buff.data();
 
   // populate ADTS header
   m[0] = 0xFF;
@@ -111,36 +210,59 @@ bool Av::parse(frame_t frame) noexcept {
   m[5] = ((encoded_size & 7) << 5) + 0x1F;
   m[6] = 0xFC;
 
+  std::copy(frame->m.begin(), frame->m.end(), m + ADTS_HEADER_SIZE);
+
   auto used = av_parser_parse2(parser_ctx,      // parser ctx
                                codec_ctx,       // codex ctx
                                &pkt->data,      // ptr to the pkt (parsed data)
                                &pkt->size,      // ptr size of the pkt (parsed data)
-                               m,               // deciphered (unchanged by parsing)
+                               m,               // ADTS header + deciphered
                                encoded_size,    // deciphered size + ADTS header
                                AV_NOPTS_VALUE,  // pts
                                AV_NOPTS_VALUE,  // dts
                                AV_NOPTS_VALUE); // pos
 
-  if ((used <= 0) || std::cmp_not_equal(used, encoded_size) || (pkt->size == 0)) {
-    log_discard(frame, used);
-    return decode_failed(frame, &pkt);
+  if ((used <= 0) || (used != encoded_size) || (pkt->size == 0)) {
+    log_discard(frame, used, encoded_size);
+    return false;
+  }
+
+  return true;
+}
+
+bool Av::parse(frame_t frame) noexcept {
+  TraceSpan span(trace::DECODE, frame->seq_num);
+  Elapsed elapsed;
+
+  if (!ready.load()) return decode_failed(frame);
+
+  auto rc = false;
+
+  if (path == RAW) {
+    // the deciphered access unit as is (send_packet copies unowned data)
+    pkt->data = frame->m.data();
+    pkt->size = std::ssize(frame->m);
+
+  } else if (!adts_packet(frame)) {
+    return decode_failed(frame);
   }
 
-  if (auto rc = avcodec_send_packet(codec_ctx, pkt); rc < 0) {
+  if (auto err = avcodec_send_packet(codec_ctx, pkt); err < 0) {
     INFO(module_id, "SEND_PACKET", "FAILED encoded_size={} size={} flags={:#b} rc={}\n", //
-         encoded_size, pkt->size, pkt->flags, rc);
-    return decode_failed(frame, &pkt);
+         std::size(frame->m), pkt->size, pkt->flags, err);
+    return decode_failed(frame);
   }
 
-  // allocate the av_frame that will receive the decoded audio data
-  auto audio_frame = av_frame_alloc();
-  if (!audio_frame) return decode_failed(frame, &pkt);
+  av_packet_unref(pkt); // reused for the next frame
 
-  if (auto rc = avcodec_receive_frame(codec_ctx, audio_frame); rc != 0) {
-    INFO("FAILED rc={}\n", module_id, "RECV_FRAME", rc);
-    return decode_failed(frame, &pkt, &audio_frame);
+  if (auto err = avcodec_receive_frame(codec_ctx, audio_frame); err != 0) {
+    INFO(module_id, "RECV_FRAME", "FAILED rc={}\n", err);
+    return decode_failed(frame);
   }
 
+  raw_failures = 0;
+  if (path == RAW) raw_decoded = true;
+
   frame->channels = codec_ctx->channels;
   frame->samples_per_channel = audio_frame->nb_samples;
 
@@ -150,19 +272,50 @@ bool Av::parse(frame_t frame) noexcept {
     frame->state = frame::DECODED;
     const float *data[] = {(float *)audio_frame->data[0], (float *)audio_frame->data[1]};
 
-    FFT left(data[0], frame->samples_per_channel, audio_frame->sample_rate);
-    FFT right(data[1], frame->samples_per_channel, audio_frame->sample_rate);
+    Stats::write(stats::DECODE_ELAPSED, elapsed.freeze(),
+                 std::make_pair("path", path == RAW ? "raw" : "adts"));
+
+    if (silent(frame, data[0], data[1], frame->samples_per_channel)) {
+      // nothing for the FFT to find, peaks remain empty
+      frame->state = frame::DSP_COMPLETE;
+      Stats::write(stats::DSP_SILENCE, true);
+
+      // the filter is skipped too, its history (samples before the silence)
+      // must not bleed into the next audible frame, silence is all but zeros
+      for (auto &d : decimators) {
+        d.reset();
+      }
+
+    } else {
+      size_t samples = frame->samples_per_channel;
+      float rate = audio_frame->sample_rate;
+      std::array<float, FFT::SAMPLES / 2> decimated[2];
+
+      if (!decimators.empty()) {
+        // band limited, a smaller FFT at the decimated rate (same bin spacing)
+        for (auto i = 0; i < 2; i++) {
+          decimators[i].process(data[i], samples, decimated[i].data());
+          data[i] = decimated[i].data();
+        }
+
+        samples /= decimators.front().factor();
+        rate /= decimators.front().factor();
+      }
+
+      FFT left(data[0], samples, rate);
+      FFT right(data[1], samples, rate);
+
+      // this goes async
+      dsp->process(frame, std::move(left), std::move(right));
+    }
 
-    // this goes async
-    dsp->process(frame, std::move(left), std::move(right));
     rc = true;
   }
 
-  av_frame_free(&audio_frame);
-  av_packet_free(&pkt);
-  frame->m.reset();
+  av_frame_unref(audio_frame); // FFT has copied the samples
+  frame->release_packet();
 
   return rc;
 }
 
-} // namespace pierre
\ No newline at end of file
+} // namespace pierre
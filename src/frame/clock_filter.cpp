@@ -0,0 +1,121 @@
+//  Pierre - Custom Light Show for Wiss Landing
+//  Copyright (C) 2022  Tim Hughey
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//  https://www.wisslanding.com
+
+#include "clock_filter.hpp"
+#include "base/pet.hpp"
+#include "lcs/logger.hpp"
+#include "lcs/stats.hpp"
+
+#include <cmath>
+#include <cstdlib>
+
+namespace pierre {
+
+bool ClockFilter::add(const ClockInfo &clock) noexcept {
+  static constexpr csv fn_id{"add"};
+
+  if (!clock.ok()) return false;
+
+  if (clock.clock_id != clock_id) {
+    restart(clock); // a new master clock has an unrelated offset
+  } else if (clock.sampleTime <= last_sample_time) {
+    return false; // already have this sample
+  }
+
+  // relative to the origin (which changes on restart)
+  auto relative = [this](const ClockInfo &c) {
+    return sample{static_cast<double>(c.sampleTime - origin_time),
+                  static_cast<double>(static_cast<int64_t>(c.rawOffset - origin_offset))};
+  };
+
+  if (count > 0) {
+    const auto s = relative(clock);
+
+    last_residual = std::llround(s.y - predict(s.x));
+    Stats::write(stats::CLOCK_RESIDUAL, Nanos(last_residual));
+
+    if (std::abs(last_residual) > STEP_MAX) {
+      INFO_AUTO("clock={:#x} offset stepped {}, restarting fit\n", clock_id,
+                pet::humanize(Nanos(last_residual)));
+
+      restart(clock);
+    }
+  }
+
+  last_sample_time = clock.sampleTime;
+
+  samples[next] = relative(clock);
+  next = (next + 1) % WINDOW;
+  if (count < WINDOW) count++;
+
+  fit();
+
+  return true;
+}
+
+void ClockFilter::fit() noexcept {
+  double x_mean{0}, y_mean{0};
+
+  for (size_t i = 0; i < count; i++) {
+    x_mean += samples[i].x;
+    y_mean += samples[i].y;
+  }
+
+  x_mean /= count;
+  y_mean /= count;
+
+  // too few samples for a meaningful drift, the mean is still less noisy
+  // than the most recent sample
+  if (count < FIT_MIN) {
+    slope = 0;
+    intercept = y_mean;
+    return;
+  }
+
+  double sxx{0}, sxy{0};
+
+  for (size_t i = 0; i < count; i++) {
+    const auto dx = samples[i].x - x_mean;
+
+    sxx += dx * dx;
+    sxy += dx * (samples[i].y - y_mean);
+  }
+
+  slope = (sxx > 0) ? sxy / sxx : 0;
+  intercept = y_mean - (slope * x_mean);
+
+  Stats::write(stats::CLOCK_DRIFT, slope * 1'000'000.0); // ppm
+}
+
+void ClockFilter::restart(const ClockInfo &clock) noexcept {
+  reset();
+
+  clock_id = clock.clock_id;
+  origin_time = clock.sampleTime;
+  origin_offset = clock.rawOffset;
+}
+
+uint64_t ClockFilter::offset_at(Nanos local) const noexcept {
+  if (!ready()) return 0;
+
+  const auto x = static_cast<double>(local.count() - static_cast<int64_t>(origin_time));
+
+  return origin_offset + static_cast<uint64_t>(std::llround(predict(x)));
+}
+
+} // namespace pierre
@@ -0,0 +1,131 @@
+//  Pierre - Custom Light Show for Wiss Landing
+//  Copyright (C) 2022  Tim Hughey
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//  https://www.wisslanding.com
+
+#include "frame/decimator.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+#include <numeric>
+
+namespace pierre {
+
+Decimator::Decimator(size_t factor) noexcept {
+  // half-band low-pass (cutoff at the decimated nyquist), kaiser windowed sinc:
+  //  h[k] = 0.5 * sinc((k - CENTER) / 2) * w[k]
+  // taps an even distance from the center are zero, they land in the odd
+  // phase which leaves only the center tap (0.5) to compute
+  const double i0_beta = std::cyl_bessel_i(0.0, KAISER_BETA);
+
+  for (size_t j = 0; j < EVEN_TAPS; j++) {
+    const double x = (double(j * 2) - double(CENTER)) / 2.0; // never zero, CENTER is odd
+    const double r = (double(j * 2) / double(CENTER)) - 1.0;  // -1 to 1 across the taps
+    const double w = std::cyl_bessel_i(0.0, KAISER_BETA * std::sqrt(1.0 - r * r)) / i0_beta;
+
+    even_taps[j] = 0.5 * (std::sin(std::numbers::pi * x) / (std::numbers::pi * x)) * w;
+  }
+
+  // normalized so the even phase sums to the center tap (unity at DC) then a
+  // gain of 2 (per halving) keeps FFT magnitudes, which scale with the FFT
+  // size, comparable to the full size FFT (frame.peaks.magnitudes applies)
+  const auto sum = std::accumulate(even_taps.begin(), even_taps.end(), 0.0f);
+  for (auto &tap : even_taps) {
+    tap *= (0.5f / sum) * 2.0f;
+  }
+
+  if (factor == 2) halvings.resize(1);
+  if (factor == 4) halvings.resize(2);
+}
+
+size_t Decimator::halve(halving &h, const float *in, size_t samples,
+                        float *out) const noexcept {
+  const size_t outputs = samples >> 1;
+  auto *even = h.even.data();
+  auto *odd = h.odd.data();
+
+  for (size_t i = 0; i < outputs; i++) {
+    even[HISTORY + i] = in[i << 1];
+    odd[HISTORY + i] = in[(i << 1) + 1];
+  }
+
+  // y[m] = sum(h[k] * x[2m - k]) where x[2i] is even[HISTORY + i] and
+  // x[2i + 1] is odd[HISTORY + i].  the odd phase is the center tap alone
+  // (0.5 with the gain of 2), x[2m - CENTER], the even phase is the rest.
+  // outputs are computed BLOCK at a time, the fixed length inner loops
+  // vectorize (even_taps are symmetric so walking forward is the same sum)
+  const float *center = odd + (HISTORY - ((CENTER + 1) >> 1));
+  size_t m = 0;
+
+  for (; (m + BLOCK) <= outputs; m += BLOCK) {
+    std::array<float, BLOCK> acc;
+
+    for (size_t k = 0; k < BLOCK; k++) {
+      acc[k] = center[m + k];
+    }
+
+    for (size_t j = 0; j < EVEN_TAPS; j++) {
+      const float tap = even_taps[j];
+      const float *x = even + m + j;
+
+      for (size_t k = 0; k < BLOCK; k++) {
+        acc[k] += tap * x[k];
+      }
+    }
+
+    std::copy(acc.begin(), acc.end(), out + m);
+  }
+
+  for (; m < outputs; m++) { // remainder (partial frames)
+    float acc = center[m];
+
+    for (size_t j = 0; j < EVEN_TAPS; j++) {
+      acc += even_taps[j] * even[m + j];
+    }
+
+    out[m] = acc;
+  }
+
+  // the newest samples are the history of the next call
+  std::copy_n(even + outputs, HISTORY, even);
+  std::copy_n(odd + outputs, HISTORY, odd);
+
+  return outputs;
+}
+
+size_t Decimator::process(const float *in, size_t samples, float *out) noexcept {
+  samples = std::min(samples, FFT::SAMPLES);
+
+  if (halvings.empty()) {
+    std::copy_n(in, samples, out);
+    return samples;
+  }
+
+  if (halvings.size() == 1) return halve(halvings[0], in, samples, out);
+
+  samples = halve(halvings[0], in, samples, between.data());
+  return halve(halvings[1], between.data(), samples, out);
+}
+
+void Decimator::reset() noexcept {
+  for (auto &h : halvings) {
+    h.even.fill(0);
+    h.odd.fill(0);
+  }
+}
+
+} // namespace pierre
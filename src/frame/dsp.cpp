@@ -17,88 +17,150 @@
 //  https://www.wisslanding.com
 
 #include "frame/dsp.hpp"
+#include "base/pet.hpp"
+#include "base/thread_util.hpp"
+#include "frame/anchor.hpp"
 #include "lcs/config.hpp"
+#include "lcs/stats.hpp"
+#include "lcs/trace.hpp"
+
+#include <algorithm>
+#include <thread>
 
 namespace pierre {
 
 // NOTE: .cpp required to hide config.hpp
 
-Dsp::Dsp() noexcept : guard(asio::make_work_guard(io_ctx)) {
+Dsp::Dsp() noexcept {
 
   static constexpr csv factor_path{"frame.dsp.concurrency_factor"};
   auto factor = config_val<double>(factor_path, 0.4);
-  const int thread_count = std::jthread::hardware_concurrency() * factor;
+  const int thread_count = std::max(1, int(std::jthread::hardware_concurrency() * factor));
 
-  INFO_INIT("sizeof={:>4} thread_count={}\n", sizeof(Dsp), thread_count);
+  joint_stereo = config_val2<Dsp, bool>("joint_stereo", false);
+  horizon = pet::from_ms<Nanos>(config_val2<Dsp, int64_t>("horizon_ms", 500));
 
-  auto latch = std::make_unique<std::latch>(thread_count);
-  shutdown_latch = std::make_shared<std::latch>(thread_count);
+  INFO_INIT("sizeof={:>4} thread_count={} joint_stereo={} horizon={}\n", sizeof(Dsp),
+            thread_count, joint_stereo, pet::humanize(horizon));
 
-  // as soon as the io_ctx starts precompute FFT windowing
-  asio::post(io_ctx, []() { FFT::init(); });
+  // precompute FFT windowing before the first frame arrives
+  FFT::init();
 
-  // start the configured number of threads (detached)
-  // the threads will finish when we reset the work guard
+  // each worker is a pipeline stage with its own queue, thread and schedule
   for (auto n = 0; n < thread_count; n++) {
-
-    // pass in a raw pointer to latch since the unique_ptr will
-    // stay in-scope until all threads are started
-    std::jthread([this, n = n, latch = latch.get()]() {
-      auto const thread_name = thread_util::set_name(thread_prefix, n);
-
-      latch->count_down();
-      INFO_THREAD_START();
-      io_ctx.run();
-
-      shutdown_latch->count_down();
-      INFO_THREAD_STOP();
-    }).detach();
+    auto &w = workers.emplace_back(std::make_unique<worker>());
+
+    w->jobs.reserve(HELD_MAX + 1);
+    w->stage.emplace(
+        thread_prefix, n,
+        [w = w.get()](job_t &j) {
+          w->jobs.emplace_back(std::move(j));
+          std::push_heap(w->jobs.begin(), w->jobs.end(), later);
+        },
+        [this, w = w.get()]() { return schedule(*w); });
   }
-
-  // caller thread waits until all threads are started
-  latch->wait();
 }
 
 Dsp::~Dsp() noexcept {
-  INFO_SHUTDOWN_REQUESTED();
+  INFO_SHUTDOWN("requested, workers={} queued={}\n", std::ssize(workers), queued.load());
+
+  // each worker stops and joins its thread then discards the held jobs
+  workers.clear();
+
+  INFO_SHUTDOWN("completed\n");
+}
 
-  guard.reset();
-  shutdown_latch->wait(); // caller waits for all threads to finish
+void Dsp::pop(worker &w) noexcept {
+  std::pop_heap(w.jobs.begin(), w.jobs.end(), later);
+  w.jobs.pop_back();
 
-  INFO_SHUTDOWN_COMPLETE();
+  queued.fetch_sub(1, std::memory_order_relaxed);
 }
 
 void Dsp::process(const frame_t frame, FFT &&left, FFT &&right) noexcept {
   frame->state = frame::DSP_IN_PROGRESS;
 
-  asio::post(io_ctx, [this, frame = std::move(frame), left = std::move(left),
-                      right = std::move(right)]() mutable {
-    _process(std::move(frame), std::move(left), std::move(right));
-  });
+  Stats::write(stats::DSP_QUEUE_DEPTH, queued.fetch_add(1, std::memory_order_relaxed) + 1);
+
+  auto j = std::make_unique<job>(frame, std::move(left), std::move(right));
+
+  // round robin, skipping full workers.  when every worker is full wait
+  // on the next (backpressure on the decode stage)
+  const auto count = std::ssize(workers);
+
+  for (auto i = 0; i < count; i++) {
+    if (workers[next_worker++ % count]->stage->try_push(std::move(j))) return;
+  }
+
+  if (!workers[next_worker++ % count]->stage->push(std::move(j))) {
+    queued.fetch_sub(1, std::memory_order_relaxed); // shutting down
+  }
 }
 
-void Dsp::_process(const frame_t frame, FFT &&left, FFT &&right) noexcept {
+Nanos Dsp::schedule(worker &w) noexcept {
+  if (w.jobs.empty()) return Nanos::zero();
 
-  // the caller sets the state to avoid a race condition with async processing
-  frame->state = frame::DSP_IN_PROGRESS;
+  auto &j = *w.jobs.front();
+  const auto now = pet::now_monotonic();
 
-  // go async and move eveything required into the lambda
-  // note: we capture a const shared_ptr to frame since we don't take ownership
+  // flushed or outdated (by render) while waiting
+  if (j.frame->state != frame::DSP_IN_PROGRESS) {
+    pop(w);
+    return now;
+  }
+
+  if (const auto anchor = Anchor::latest(); anchor.ready()) {
+    const auto deadline = anchor.frame_to_local_time(j.frame->timestamp);
+
+    if (deadline <= now) {
+      // render has passed the frame, it can no longer make it
+      j.frame->state.store_if_equal(frame::DSP_IN_PROGRESS, frame::OUTDATED);
+      pipeline::record_dropped(thread_prefix);
+      pop(w);
+      return now;
+    }
 
-  // due to limited threads processing of frames will queue (e.g. at start of play)
-  // it is possible that one or more of the queued frames could be marked as out of
-  // date by Racked. if the frame is anything other than decoded we skip peak
-  // detection.
+    // too early, wake at the horizon (or a new arrival) unless too many are held
+    if (((deadline - now) > horizon) && (w.jobs.size() <= HELD_MAX)) {
+      return deadline - horizon;
+    }
+  }
+
+  _process(j);
+  pop(w);
+
+  return w.jobs.empty() ? Nanos::zero() : now;
+}
+
+void Dsp::_process(job &j) noexcept {
+  auto &[frame, left, right] = j;
+
+  // the state is set by process(), scheduling skips frames marked outdated by
+  // Racked while waiting.  processing takes time so the state is checked again
+  // between each step.
 
   if (frame->state == frame::DSP_IN_PROGRESS) {
     // the state hasn't changed, proceed with processing
-    left.process();
+    if (joint_stereo) {
+      TraceSpan span(trace::FFT_STEREO, frame->seq_num);
+      FFT::process(left, right); // both channels, single transform
+
+    } else {
+      {
+        TraceSpan span(trace::FFT_LEFT, frame->seq_num);
+        left.process();
+      }
 
-    // check before starting the right channel (left required processing time)
-    if (frame->state == frame::DSP_IN_PROGRESS) right.process();
+      // check before starting the right channel (left required processing time)
+      if (frame->state == frame::DSP_IN_PROGRESS) {
+        TraceSpan span(trace::FFT_RIGHT, frame->seq_num);
+        right.process();
+      }
+    }
 
     // check again since thr right channel also required processing time
     if (frame->state == frame::DSP_IN_PROGRESS) {
+      TraceSpan span(trace::PEAKS, frame->seq_num);
       left.find_peaks(frame->peaks, Peaks::CHANNEL::LEFT);
 
       if (frame->state == frame::DSP_IN_PROGRESS) {
@@ -20,17 +20,27 @@
 
 #include "frame/fft.hpp"
 #include "base/elapsed.hpp"
+#include "lcs/logger.hpp"
 
 #include <algorithm>
+#include <bit>
 #include <cmath>
+#include <cstring>
 #include <exception>
 #include <functional>
+#include <initializer_list>
 #include <iterator>
 #include <limits>
+#include <mutex>
 #include <numbers>
 #include <numeric>
 #include <ranges>
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define PIERRE_FFT_X86 1
+#endif
+
 namespace pierre {
 
 using namespace fft;
@@ -39,7 +49,11 @@ constexpr float PI2{std::numbers::pi * 2};
 constexpr float PI4{std::numbers::pi * 4};
 constexpr float PI6{std::numbers::pi * 6};
 
-static const size_t _samples{1024};
+static constexpr size_t _samples{FFT::SAMPLES};
+static constexpr size_t _half{_samples >> 1}; // complex FFT size
+static constexpr size_t _bits{std::countr_zero(_samples)};
+static constexpr size_t _sizes{std::countr_zero(FFT::DECIMATION_MAX) + 1}; // N, N/2 ...
+static constexpr size_t _flag_block{16}; // find_peaks() bins compared (and flags tested) at once
 static const window _window_type{window::Hann};
 static bool _with_compensation = false;
 static const float _win_compensation_factors[] = {
@@ -55,172 +69,414 @@ static const float _win_compensation_factors[] = {
     1.5029392863 * 2.0  // welch
 };
 
-static reals_t _wwf;
+namespace {
 
-FFT::FFT(const float *reals, size_t samples, const float frequency)
-    : _reals(_samples, 0),         //
-      _sampling_freq(frequency),   //
-      _max_peaks(_samples >> 1),   //
-      _imaginary(_samples, 0),     //
-      _power(std::log2f(_samples)) //
-{
+// precomputed by FFT::init(), read only thereafter
+struct tables {
+  // window weighing factors (full length, symmetrical) for each FFT size, the
+  // N >> s point window is at [s]
+  alignas(64) std::array<std::array<float, _samples>, _sizes> wwf;
 
-  init(); // calc the window weighing factors
+  // butterfly twiddles for stage half size l1 are at [l1, 2 * l1) so every
+  // stage with l1 >= simd lanes is aligned for the kernels
+  alignas(64) std::array<float, _samples> tw_re;
+  alignas(64) std::array<float, _samples> tw_im;
 
-  if (samples != _samples) {
-    throw std::runtime_error("unsupported number of samples");
-  }
+  // twiddles to split the N/2 complex result into the N real result
+  alignas(64) std::array<float, _half + 1> split_re;
+  alignas(64) std::array<float, _half + 1> split_im;
+
+  // bit reversal for the N point (joint stereo) FFT, for a smaller FFT use
+  // bit_rev[n] >> s (n < N >> s), e.g. >> 1 for the N/2 point FFT
+  std::array<uint16_t, _samples> bit_rev;
+};
+
+static tables _tables;
+static std::once_flag _init_once;
+
+// per thread scratch (DSP threads reuse it for every FFT)
+struct workspace {
+  alignas(64) std::array<float, _samples> re;
+  alignas(64) std::array<float, _samples> im;
+  alignas(64) std::array<float, _half + 1> x_re;
+  alignas(64) std::array<float, _half + 1> x_im;
+};
+
+static thread_local workspace _ws;
 
-  for (size_t i = 0; i < samples; i++) {
-    _reals[i] = reals[i];
+// FFT size n is N >> shift(n)
+constexpr size_t shift(size_t n) noexcept { return _bits - std::countr_zero(n); }
+
+// butterfly kernels (stages) for an n point complex FFT, input in bit reversed order
+
+void stages_scalar(float *re, float *im, size_t n, size_t l1_end) noexcept {
+  const auto &t = _tables;
+
+  for (size_t l1 = 1; l1 < l1_end; l1 <<= 1) {
+    const size_t l2 = l1 << 1;
+
+    for (size_t g = 0; g < n; g += l2) {
+      for (size_t j = 0; j < l1; j++) {
+        const size_t i = g + j;
+        const size_t i1 = i + l1;
+        const float wr = t.tw_re[l1 + j];
+        const float wi = t.tw_im[l1 + j];
+
+        const float t1 = wr * re[i1] - wi * im[i1];
+        const float t2 = wr * im[i1] + wi * re[i1];
+        re[i1] = re[i] - t1;
+        im[i1] = im[i] - t2;
+        re[i] += t1;
+        im[i] += t2;
+      }
+    }
   }
 }
 
-void FFT::complex_to_magnitude() {
-  // vM is half the size of vReal and vImag
-  for (size_t i = 0; i < _samples; i++) {
-    _reals[i] = std::hypot(_reals[i], _imaginary[i]);
+void butterflies_scalar(float *re, float *im, size_t n) noexcept { stages_scalar(re, im, n, n); }
+
+#ifdef PIERRE_FFT_X86
+__attribute__((target("sse2"))) //
+void butterflies_sse2(float *re, float *im, size_t n) noexcept {
+  const auto &t = _tables;
+  constexpr size_t lanes{4};
+
+  stages_scalar(re, im, n, lanes);
+
+  for (size_t l1 = lanes; l1 < n; l1 <<= 1) {
+    const size_t l2 = l1 << 1;
+
+    for (size_t g = 0; g < n; g += l2) {
+      for (size_t j = 0; j < l1; j += lanes) {
+        const size_t i = g + j;
+        const size_t i1 = i + l1;
+        const auto wr = _mm_load_ps(&t.tw_re[l1 + j]);
+        const auto wi = _mm_load_ps(&t.tw_im[l1 + j]);
+        const auto br = _mm_load_ps(re + i1);
+        const auto bi = _mm_load_ps(im + i1);
+        const auto ar = _mm_load_ps(re + i);
+        const auto ai = _mm_load_ps(im + i);
+
+        const auto t1 = _mm_sub_ps(_mm_mul_ps(wr, br), _mm_mul_ps(wi, bi));
+        const auto t2 = _mm_add_ps(_mm_mul_ps(wr, bi), _mm_mul_ps(wi, br));
+
+        _mm_store_ps(re + i1, _mm_sub_ps(ar, t1));
+        _mm_store_ps(im + i1, _mm_sub_ps(ai, t2));
+        _mm_store_ps(re + i, _mm_add_ps(ar, t1));
+        _mm_store_ps(im + i, _mm_add_ps(ai, t2));
+      }
+    }
   }
 }
 
-void FFT::compute(direction dir) {
-  // Reverse bits /
-  size_t j = 0;
-  for (size_t i = 0; i < (_samples - 1); i++) {
-    if (i < j) {
-      std::swap(_reals[i], _reals[j]);
-      if (dir == direction::Reverse) {
-        std::swap(_imaginary[i], _imaginary[j]);
+__attribute__((target("avx2,fma"))) //
+void butterflies_avx2(float *re, float *im, size_t n) noexcept {
+  const auto &t = _tables;
+  constexpr size_t lanes{8};
+
+  stages_scalar(re, im, n, lanes);
+
+  for (size_t l1 = lanes; l1 < n; l1 <<= 1) {
+    const size_t l2 = l1 << 1;
+
+    for (size_t g = 0; g < n; g += l2) {
+      for (size_t j = 0; j < l1; j += lanes) {
+        const size_t i = g + j;
+        const size_t i1 = i + l1;
+        const auto wr = _mm256_load_ps(&t.tw_re[l1 + j]);
+        const auto wi = _mm256_load_ps(&t.tw_im[l1 + j]);
+        const auto br = _mm256_load_ps(re + i1);
+        const auto bi = _mm256_load_ps(im + i1);
+        const auto ar = _mm256_load_ps(re + i);
+        const auto ai = _mm256_load_ps(im + i);
+
+        const auto t1 = _mm256_fmsub_ps(wr, br, _mm256_mul_ps(wi, bi));
+        const auto t2 = _mm256_fmadd_ps(wr, bi, _mm256_mul_ps(wi, br));
+
+        _mm256_store_ps(re + i1, _mm256_sub_ps(ar, t1));
+        _mm256_store_ps(im + i1, _mm256_sub_ps(ai, t2));
+        _mm256_store_ps(re + i, _mm256_add_ps(ar, t1));
+        _mm256_store_ps(im + i, _mm256_add_ps(ai, t2));
       }
     }
-    size_t k = (_samples >> 1);
-    while (k <= j) {
-      j -= k;
-      k >>= 1;
-    }
-    j += k;
   }
+}
 
-  // Compute the FFT
-  float c1 = -1.0;
-  float c2 = 0.0;
-  size_t l2 = 1;
-  for (uint_fast8_t l = 0; (l < _power); l++) {
-    size_t l1 = l2;
-    l2 <<= 1;
-    float u1 = 1.0;
-    float u2 = 0.0;
-    for (j = 0; j < l1; j++) {
-      for (size_t i = j; i < _samples; i += l2) {
-        size_t i1 = i + l1;
-        float t1 = u1 * _reals[i1] - u2 * _imaginary[i1];
-        float t2 = u1 * _imaginary[i1] + u2 * _reals[i1];
-        _reals[i1] = _reals[i] - t1;
-        _imaginary[i1] = _imaginary[i] - t2;
-        _reals[i] += t1;
-        _imaginary[i] += t2;
+__attribute__((target("avx512f"))) //
+void butterflies_avx512(float *re, float *im, size_t n) noexcept {
+  const auto &t = _tables;
+  constexpr size_t lanes{16};
+
+  stages_scalar(re, im, n, lanes);
+
+  for (size_t l1 = lanes; l1 < n; l1 <<= 1) {
+    const size_t l2 = l1 << 1;
+
+    for (size_t g = 0; g < n; g += l2) {
+      for (size_t j = 0; j < l1; j += lanes) {
+        const size_t i = g + j;
+        const size_t i1 = i + l1;
+        const auto wr = _mm512_load_ps(&t.tw_re[l1 + j]);
+        const auto wi = _mm512_load_ps(&t.tw_im[l1 + j]);
+        const auto br = _mm512_load_ps(re + i1);
+        const auto bi = _mm512_load_ps(im + i1);
+        const auto ar = _mm512_load_ps(re + i);
+        const auto ai = _mm512_load_ps(im + i);
+
+        const auto t1 = _mm512_fmsub_ps(wr, br, _mm512_mul_ps(wi, bi));
+        const auto t2 = _mm512_fmadd_ps(wr, bi, _mm512_mul_ps(wi, br));
+
+        _mm512_store_ps(re + i1, _mm512_sub_ps(ar, t1));
+        _mm512_store_ps(im + i1, _mm512_sub_ps(ai, t2));
+        _mm512_store_ps(re + i, _mm512_add_ps(ar, t1));
+        _mm512_store_ps(im + i, _mm512_add_ps(ai, t2));
       }
-      float z = ((u1 * c1) - (u2 * c2));
-      u2 = ((u1 * c2) + (u2 * c1));
-      u1 = z;
     }
+  }
+}
+#endif
+
+using butterflies_fn = void (*)(float *, float *, size_t) noexcept;
+static butterflies_fn _butterflies{butterflies_scalar};
 
-    float cTemp = 0.5 * c1;
-    c2 = std::sqrt(0.5 - cTemp);
-    c1 = std::sqrt(0.5 + cTemp);
+} // namespace
+
+FFT::FFT(const float *reals, size_t samples, const float frequency)
+    : _sampling_freq(frequency), _n(samples) //
+{
+  init(); // tables are built once, this is a no-op thereafter
 
-    c2 = dir == direction::Forward ? -c2 : c2;
+  if (!std::has_single_bit(_n) || (_n > _samples) || (shift(_n) >= _sizes)) {
+    throw std::runtime_error("unsupported number of samples");
   }
-  // Scaling for reverse transform
-  if (dir != direction::Forward) {
-    for (size_t i = 0; i < _samples; i++) {
-      _reals[i] /= _samples;
-      _imaginary[i] /= _samples;
-    }
+
+  std::copy_n(reals, _n, _reals.begin());
+}
+
+void FFT::complex_to_magnitude() noexcept {
+  // the spectrum of real input is symmetrical, only bins [0, N/2] are unique.
+  // find_peaks() looks one bin beyond N/2 which mirrors bin N/2 - 1
+  const size_t half = _n >> 1;
+
+  for (size_t i = 0; i <= half; i++) {
+    _reals[i] = std::sqrt(sq(_ws.x_re[i]) + sq(_ws.x_im[i]));
+  }
+
+  _reals[half + 1] = _reals[half - 1];
+}
+
+void FFT::compute() noexcept {
+  auto &ws = _ws;
+  const auto &t = _tables;
+
+  // pack the even/odd real samples as the real/imaginary parts of a N/2
+  // complex sequence (in bit reversed order for the butterflies)
+  const size_t half = _n >> 1;
+  const auto rev_shift = shift(_n) + 1;
+
+  for (size_t n = 0; n < half; n++) {
+    const auto r = t.bit_rev[n] >> rev_shift;
+
+    ws.re[r] = _reals[n << 1];
+    ws.im[r] = _reals[(n << 1) + 1];
+  }
+
+  _butterflies(ws.re.data(), ws.im.data(), half);
+
+  // split the N/2 complex result into the N real result (bins 0 through N/2),
+  // the split twiddles of a smaller FFT are every (N / n)th of the N point
+  const size_t stride = _samples / _n;
+
+  for (size_t k = 0; k <= half; k++) {
+    const size_t a = k & (half - 1);          // Z[k] (Z[N/2] == Z[0])
+    const size_t b = (half - k) & (half - 1); // Z[N/2 - k]
+    const size_t w = k * stride;
+
+    const float er = 0.5f * (ws.re[a] + ws.re[b]);
+    const float ei = 0.5f * (ws.im[a] - ws.im[b]);
+    const float or_ = 0.5f * (ws.im[a] + ws.im[b]);
+    const float oi = -0.5f * (ws.re[a] - ws.re[b]);
+
+    ws.x_re[k] = er + (t.split_re[w] * or_) - (t.split_im[w] * oi);
+    ws.x_im[k] = ei + (t.split_re[w] * oi) + (t.split_im[w] * or_);
   }
 }
 
 void FFT::dc_removal() noexcept {
-  double sum = std::accumulate(_reals.begin(), _reals.end(), 0.0);
-  double mean = sum / _samples;
+  double sum = std::accumulate(_reals.begin(), _reals.begin() + _n, 0.0);
+  float mean = sum / _n;
 
-  for (size_t i = 1; i < ((_samples >> 1) + 1); i++) {
+  for (size_t i = 1; i < ((_n >> 1) + 1); i++) {
     _reals[i] -= mean;
   }
 }
 
 void FFT::find_peaks(Peaks &peaks, Peaks::CHANNEL channel) noexcept {
+  // result of fft is symmetrical, look at first half only.  local maxima can
+  // not be adjacent so there are at most N/4 (+1 for the branch free store)
+  static constexpr size_t max_maxima{(_samples >> 2) + 1};
+  static_assert(max_maxima <= Peaks::MAX_CANDIDATES, "too many candidates for Peaks");
+
+  const size_t half = _n >> 1;
+
+  // flag the local maxima _flag_block bins at a time, the fixed length compares
+  // vectorize.  the last block may pass half (flags are padded), those flags
+  // are cleared
+  alignas(64) std::array<uint8_t, (_samples >> 1) + 1 + _flag_block> is_max;
+  const float *r = _reals.data();
+
+  is_max[0] = 0;
+  for (size_t b = 1; b <= half; b += _flag_block) {
+    for (size_t k = 0; k < _flag_block; k++) {
+      const size_t i = b + k;
+      is_max[i] = (r[i - 1] < r[i]) & (r[i] > r[i + 1]);
+    }
+  }
 
-  // result of fft is symmetrical, look at first half only
-  for (size_t i = 1; i < ((_samples >> 1) + 1); i++) {
-    const float a = _reals[i - 1];
-    const float b = _reals[i];
-    const float c = _reals[i + 1];
+  std::fill_n(is_max.begin() + half + 1, _flag_block, 0);
 
-    if ((a < b) && (b > c)) {
-      peaks.emplace(mag_at_index(i), freq_at_index(i), channel);
+  // compress the flagged bins, skipping blocks without a maximum (most)
+  std::array<uint16_t, max_maxima> bins;
+  size_t n = 0;
+
+  for (size_t b = 0; b <= half; b += _flag_block) {
+    std::array<uint64_t, _flag_block / sizeof(uint64_t)> flags;
+    std::memcpy(flags.data(), is_max.data() + b, _flag_block);
+    if (std::ranges::all_of(flags, [](uint64_t f) { return f == 0; })) continue;
+
+    for (size_t i = b; i < (b + _flag_block); i++) {
+      bins[n] = i;
+      n += is_max[i];
     }
   }
+
+  std::array<float, max_maxima> mags;
+  std::array<float, max_maxima> freqs;
+
+  for (size_t k = 0; k < n; k++) {
+    mags[k] = mag_at_index(bins[k]);
+    freqs[k] = freq_at_index(bins[k]);
+  }
+
+  peaks.select(channel, std::span(mags.data(), n), std::span(freqs.data(), n));
 }
 
 void FFT::init() { // static
 
-  if (_wwf.size() == 0) {
-    _wwf.reserve(_samples >> 1);
-    auto wwf = std::back_inserter(_wwf);
+  std::call_once(_init_once, []() {
+    auto &t = _tables;
 
-    float samplesMinusOne = (float(_samples) - 1.0);
     float compensationFactor = _win_compensation_factors[static_cast<uint_fast8_t>(_window_type)];
-    for (size_t i = 0; i < (_samples >> 1); i++) {
-      float indexMinusOne = float(i);
-      float ratio = (indexMinusOne / samplesMinusOne);
-      float weighingFactor = 1.0;
-      // Compute and record weighting factor
-      switch (_window_type) {
-      case window::Rectangle: // rectangle (box car)
-        weighingFactor = 1.0;
-        break;
-      case window::Hamming: // hamming
-        weighingFactor = 0.54 - (0.46 * cos(PI2 * ratio));
-        break;
-      case window::Hann: // hann
-        weighingFactor = 0.54 * (1.0 - cos(PI2 * ratio));
-        break;
-      case window::Triangle: // triangle (Bartlett)
-        weighingFactor =
-            1.0 - ((2.0 * abs(indexMinusOne - (samplesMinusOne / 2.0))) / samplesMinusOne);
-        break;
-      case window::Nuttall: // nuttall
-        weighingFactor = 0.355768 - (0.487396 * (cos(PI2 * ratio))) +
-                         (0.144232 * (cos(PI4 * ratio))) - (0.012604 * (cos(PI6 * ratio)));
-        break;
-      case window::Blackman: // blackman
-        weighingFactor = 0.42323 - (0.49755 * (cos(PI2 * ratio))) + (0.07922 * (cos(PI4 * ratio)));
-        break;
-      case window::Blackman_Nuttall: // blackman nuttall
-        weighingFactor = 0.3635819 - (0.4891775 * (cos(PI2 * ratio))) +
-                         (0.1365995 * (cos(PI4 * ratio))) - (0.0106411 * (cos(PI6 * ratio)));
-        break;
-      case window::Blackman_Harris: // blackman harris
-        weighingFactor = 0.35875 - (0.48829 * (cos(PI2 * ratio))) + (0.14128 * (cos(PI4 * ratio))) -
-                         (0.01168 * (cos(PI6 * ratio)));
-        break;
-      case window::Flat_top: // flat top
-        weighingFactor =
-            0.2810639 - (0.5208972 * cos(PI2 * ratio)) + (0.1980399 * cos(PI4 * ratio));
-        break;
-      case window::Welch: // welch
-        weighingFactor =
-            1.0 - (sq(indexMinusOne - samplesMinusOne / 2.0) / (samplesMinusOne / 2.0));
-        break;
+
+    // a window for each FFT size
+    for (size_t s = 0; s < _sizes; s++) {
+      const size_t n = _samples >> s;
+
+      float samplesMinusOne = (float(n) - 1.0);
+      for (size_t i = 0; i < (n >> 1); i++) {
+        float indexMinusOne = float(i);
+        float ratio = (indexMinusOne / samplesMinusOne);
+        float weighingFactor = 1.0;
+        // Compute and record weighting factor
+        switch (_window_type) {
+        case window::Rectangle: // rectangle (box car)
+          weighingFactor = 1.0;
+          break;
+        case window::Hamming: // hamming
+          weighingFactor = 0.54 - (0.46 * cos(PI2 * ratio));
+          break;
+        case window::Hann: // hann
+          weighingFactor = 0.54 * (1.0 - cos(PI2 * ratio));
+          break;
+        case window::Triangle: // triangle (Bartlett)
+          weighingFactor =
+              1.0 - ((2.0 * abs(indexMinusOne - (samplesMinusOne / 2.0))) / samplesMinusOne);
+          break;
+        case window::Nuttall: // nuttall
+          weighingFactor = 0.355768 - (0.487396 * (cos(PI2 * ratio))) +
+                           (0.144232 * (cos(PI4 * ratio))) - (0.012604 * (cos(PI6 * ratio)));
+          break;
+        case window::Blackman: // blackman
+          weighingFactor =
+              0.42323 - (0.49755 * (cos(PI2 * ratio))) + (0.07922 * (cos(PI4 * ratio)));
+          break;
+        case window::Blackman_Nuttall: // blackman nuttall
+          weighingFactor = 0.3635819 - (0.4891775 * (cos(PI2 * ratio))) +
+                           (0.1365995 * (cos(PI4 * ratio))) - (0.0106411 * (cos(PI6 * ratio)));
+          break;
+        case window::Blackman_Harris: // blackman harris
+          weighingFactor = 0.35875 - (0.48829 * (cos(PI2 * ratio))) +
+                           (0.14128 * (cos(PI4 * ratio))) - (0.01168 * (cos(PI6 * ratio)));
+          break;
+        case window::Flat_top: // flat top
+          weighingFactor =
+              0.2810639 - (0.5208972 * cos(PI2 * ratio)) + (0.1980399 * cos(PI4 * ratio));
+          break;
+        case window::Welch: // welch
+          weighingFactor =
+              1.0 - (sq(indexMinusOne - samplesMinusOne / 2.0) / (samplesMinusOne / 2.0));
+          break;
+        }
+        if (_with_compensation) {
+          weighingFactor *= compensationFactor;
+        }
+
+        // the window is symmetrical, store both halves so windowing is a single pass
+        t.wwf[s][i] = weighingFactor;
+        t.wwf[s][n - (i + 1)] = weighingFactor;
       }
-      if (_with_compensation) {
-        weighingFactor *= compensationFactor;
+    }
+
+    // butterfly twiddles (forward): w = e^(-i * pi * j / l1)
+    for (size_t l1 = 1; l1 < _samples; l1 <<= 1) {
+      for (size_t j = 0; j < l1; j++) {
+        const double theta = std::numbers::pi * j / l1;
+
+        t.tw_re[l1 + j] = std::cos(theta);
+        t.tw_im[l1 + j] = -std::sin(theta);
       }
+    }
+
+    // split twiddles: W = e^(-i * 2pi * k / N)
+    for (size_t k = 0; k <= _half; k++) {
+      const double theta = 2.0 * std::numbers::pi * k / _samples;
 
-      wwf = weighingFactor;
+      t.split_re[k] = std::cos(theta);
+      t.split_im[k] = -std::sin(theta);
     }
-  }
+
+    // bit reversal for the N point complex FFT
+    const auto bits = std::countr_zero(_samples);
+    for (uint32_t n = 0; n < _samples; n++) {
+      uint32_t r = 0;
+
+      for (auto b = 0; b < bits; b++) {
+        r |= ((n >> b) & 1) << (bits - 1 - b);
+      }
+
+      t.bit_rev[n] = r;
+    }
+
+    // select the butterfly kernel for this cpu
+    string_view kernel{"scalar"};
+
+#ifdef PIERRE_FFT_X86
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx512f")) {
+      _butterflies = butterflies_avx512;
+      kernel = "avx512";
+    } else if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+      _butterflies = butterflies_avx2;
+      kernel = "avx2";
+    } else if (__builtin_cpu_supports("sse2")) {
+      _butterflies = butterflies_sse2;
+      kernel = "sse2";
+    }
+#endif
+
+    INFO(module_id, "INIT", "samples={} kernel={}\n", _samples, kernel);
+  });
 }
 
 Magnitude FFT::mag_at_index(const size_t i) const {
@@ -237,32 +493,70 @@ Frequency FFT::freq_at_index(size_t y) {
   const float c = _reals[y + 1];
 
   float delta = 0.5 * ((a - c) / (a - (2.0 * b) + c));
-  float frequency = ((y + delta) * _sampling_freq) / (_samples - 1);
-  if (y == (_samples >> 1)) {
-    // To improve calculation on edge values
-    frequency = ((y + delta) * _sampling_freq) / _samples;
-  }
 
-  return Frequency(frequency);
+  // bin spacing is sample rate / FFT size, the same for a decimated FFT (both
+  // are reduced by the decimation factor).  dividing by N - 1 overstates every
+  // frequency by 1 / N, noticeable for the smaller FFT
+  return Frequency(((y + delta) * _sampling_freq) / _n);
 }
 
-void FFT::process() {
+void FFT::process() noexcept {
   dc_removal();
   windowing(direction::Forward);
-  compute(direction::Forward);
+  compute();
   complex_to_magnitude();
 }
 
-void FFT::windowing(direction dir) {
+void FFT::process(FFT &left, FFT &right) noexcept { // static
+  auto &ws = _ws;
+  const auto &t = _tables;
+
+  for (auto *fft : {&left, &right}) {
+    fft->dc_removal();
+    fft->windowing(direction::Forward);
+  }
+
+  // left is the real part, right the imaginary part of a single N point FFT
+  // (both channels are the same size)
+  const size_t size = left._n;
+  const size_t half = size >> 1;
+  const auto rev_shift = shift(size);
+
+  for (size_t n = 0; n < size; n++) {
+    const auto r = t.bit_rev[n] >> rev_shift;
+
+    ws.re[r] = left._reals[n];
+    ws.im[r] = right._reals[n];
+  }
+
+  _butterflies(ws.re.data(), ws.im.data(), size);
+
+  // separate the spectra via conjugate symmetry of real input:
+  //  L[k] = (Z[k] + conj(Z[N - k])) / 2
+  //  R[k] = (Z[k] - conj(Z[N - k])) / 2i
+  for (size_t k = 0; k <= half; k++) {
+    const size_t a = k;
+    const size_t b = (size - k) & (size - 1);
+
+    left._reals[k] = 0.5f * std::sqrt(sq(ws.re[a] + ws.re[b]) + sq(ws.im[a] - ws.im[b]));
+    right._reals[k] = 0.5f * std::sqrt(sq(ws.im[a] + ws.im[b]) + sq(ws.re[a] - ws.re[b]));
+  }
+
+  // find_peaks() looks one bin beyond N/2 which mirrors bin N/2 - 1
+  left._reals[half + 1] = left._reals[half - 1];
+  right._reals[half + 1] = right._reals[half - 1];
+}
+
+void FFT::windowing(direction dir) noexcept {
+  const auto &wwf = _tables.wwf[shift(_n)];
+
   if (dir == direction::Forward) {
-    for (size_t i = 0; i < (_samples >> 1); i++) {
-      _reals[i] *= _wwf[i];
-      _reals[_samples - (i + 1)] *= _wwf[i];
+    for (size_t i = 0; i < _n; i++) {
+      _reals[i] *= wwf[i];
     }
   } else {
-    for (size_t i = 0; i < (_samples >> 1); i++) {
-      _reals[i] /= _wwf[i];
-      _reals[_samples - (i + 1)] /= _wwf[i];
+    for (size_t i = 0; i < _n; i++) {
+      _reals[i] /= wwf[i];
     }
   }
 }
@@ -23,10 +23,12 @@
 #include "base/input_info.hpp"
 #include "base/uint8v.hpp"
 #include "fft.hpp"
+#include "frame_pool.hpp"
 #include "io/io.hpp"
-#include "lcs/config.hpp"
 #include "lcs/stats.hpp"
+#include "lcs/trace.hpp"
 
+#include <array>
 #include <iterator>
 #include <ranges>
 #include <sodium.h>
@@ -78,63 +80,74 @@ notes:
  3.  to creata a ChaCha nonce from the Apple nonce the first four (4) bytes
      are zeroed */
 
-static constexpr csv cfg_cipher_buff_size{"frame.cipher.buffer_size"};
+static constexpr std::ptrdiff_t CIPHERED_BEGIN{12};
+static constexpr std::ptrdiff_t NONCE_MINI_BYTES{8};
+static constexpr std::ptrdiff_t TAG_END{24};
+static constexpr std::ptrdiff_t TAG_BYTES{crypto_aead_chacha20poly1305_ietf_ABYTES};
 
 // Frame API
 
-bool Frame::decipher(uint8v packet, const uint8v key) noexcept {
+frame_t Frame::create(uint8v &packet) noexcept {
+  auto frame = FramePool::acquire<Frame>(packet);
 
-  // ensure we know how big of a cipher buffer to allocate
-  if (!cipher_buff_size) cipher_buff_size = config()->at(cfg_cipher_buff_size).value_or(0x4000);
+  Trace::instant(trace::PACKET_READ, frame->seq_num);
 
-  // the nonce for libsodium is 12 bytes however the packet only provides 8
-  uint8v nonce(4, 0x00); // pad the nonce for libsodium
-  // mini nonce end - 8; copy 8 bytes total
-  ranges::copy_n(packet.from_end(8), 8, std::back_inserter(nonce));
-
-  // tag end - 24 bytes; 16 bytes total
-  std::span<uint8_t> tag(packet.from_end(24), 16);
-
-  // aad begin + 4 bytes; 8 bytes total
-  std::span<uint8_t> aad(packet.from_begin(4), 8);
+  return frame;
+}
 
-  // ciphered data begin + 12, end - 8
-  std::span<uint8_t> ciphered(packet.from_begin(12), packet.from_end(8));
+bool Frame::decipher(uint8v &&p, const uint8v &key) noexcept {
+  TraceSpan span(trace::DECIPHER, seq_num);
 
   if (key.empty()) {
     state = frame::NO_SHARED_KEY;
 
-  } else if (version != RTPv2) {
+  } else if ((version != RTPv2) || (std::ssize(p) <= (CIPHERED_BEGIN + TAG_END))) {
     state = frame::INVALID;
 
   } else [[likely]] {
+    // take ownership of the packet, it is deciphered in place
+    packet = std::move(p);
 
     Stats::write(stats::RTSP_AUDIO_CIPHERED, std::ssize(packet));
 
-    unsigned long long consumed{0};
-
-    cipher_rc =                                    //
-        crypto_aead_chacha20poly1305_ietf_decrypt( // -1 == failure
-            Av::m_buffer(m, cipher_buff_size),     // m (av leaves room for ADTS)
-            &consumed,                             // bytes deciphered
-            nullptr,                               // nanoseconds (unused, must be nullptr)
-            ciphered.data(),                       // ciphered data
-            ciphered.size(),                       // ciphered length
-            aad.data(),                            // authenticated additional data
-            aad.size(),                            // authenticated additional data length
-            nonce.data(),                          // the nonce
-            key.data());                           // shared key (from SETUP message)
-
-    if ((cipher_rc >= 0) && (consumed > 0)) {
-      Av::m_buffer_resize(m, consumed); // resizes m to include header + cipher data
-
-      Stats::write(stats::RTSP_AUDIO_DECIPERED, std::ssize(*m));
+    // the nonce for libsodium is 12 bytes however the packet only provides 8
+    // so pad the first four bytes (stack allocated, no heap)
+    std::array<uint8_t, crypto_aead_chacha20poly1305_ietf_NPUBBYTES> nonce{0};
+    ranges::copy_n(packet.from_end(NONCE_MINI_BYTES), NONCE_MINI_BYTES,
+                   nonce.end() - NONCE_MINI_BYTES);
+
+    // tag end - 24 bytes; 16 bytes total
+    std::span<uint8_t> tag(packet.from_end(TAG_END), TAG_BYTES);
+
+    // aad begin + 4 bytes; 8 bytes total
+    std::span<uint8_t> aad(packet.from_begin(4), 8);
+
+    // ciphered data begin + 12, end - 24 (tag is detached)
+    std::span<uint8_t> ciphered(packet.from_begin(CIPHERED_BEGIN), packet.from_end(TAG_END));
+
+    cipher_rc =                                             //
+        crypto_aead_chacha20poly1305_ietf_decrypt_detached( // -1 == failure
+            ciphered.data(),                                // m (in place)
+            nullptr,                                        // nsec (unused, must be nullptr)
+            ciphered.data(),                                // ciphered data
+            ciphered.size(),                                // ciphered length
+            tag.data(),                                     // mac (detached tag)
+            aad.data(),                                     // authenticated additional data
+            aad.size(),                                     // authenticated additional data length
+            nonce.data(),                                   // the nonce
+            key.data());                                    // shared key (from SETUP message)
+
+    if ((cipher_rc >= 0) && !ciphered.empty()) {
+      // m is the deciphered data (a raw AAC access unit)
+      m = ciphered;
+
+      Stats::write(stats::RTSP_AUDIO_DECIPERED, std::ssize(m));
       state = frame::DECIPHERED;
 
     } else if (cipher_rc < 0) {
       state = frame::DECIPHER_FAILURE;
 
-    } else if (consumed <= 0) {
+    } else if (ciphered.empty()) {
       state = frame::EMPTY;
 
     } else { // catch all
@@ -151,9 +164,12 @@ bool Frame::decode(Av *av) noexcept {
   return state.deciphered() && av->parse(ptr()) && state.dsp_any();
 }
 
-frame::state Frame::state_now(AnchorLast anchor, const Nanos &lead_time) noexcept {
+frame::state Frame::state_now(const AnchorLast &anchor, const Nanos &lead_time) noexcept {
   if (anchor.ready()) {
-    _anchor.emplace(std::move(anchor)); // cache the anchor used for this calculation
+    // cache the anchor used for this calculation (only when Anchor derived a new one)
+    if (!_anchor.has_value() || (_anchor->generation != anchor.generation)) {
+      _anchor.emplace(anchor);
+    }
 
     auto diff = _anchor->frame_local_time_diff(timestamp);
 
@@ -225,8 +241,8 @@ const string Frame::inspect(bool full) const noexcept {
     fmt::format_to(w, " sync_wait={}", pet::humanize(sync_wait()));
   }
 
-  if (m.has_value() && (std::ssize(*m) <= 0)) {
-    fmt::format_to(w, " consumed={}", std::ssize(*m));
+  if (!packet.empty() && (std::ssize(m) <= 0)) {
+    fmt::format_to(w, " consumed={}", std::ssize(m));
   }
 
   if (state == frame::READY && silent()) {
@@ -250,7 +266,7 @@ const string Frame::inspect_safe(frame_t frame, bool full) noexcept { // static
 }
 
 void Frame::log_decipher() const noexcept {
-  [[maybe_unused]] auto consumed = m.has_value() ? std::ssize(*m) : 0;
+  [[maybe_unused]] auto consumed = std::ssize(m);
 
   if (state.deciphered()) {
     INFOX(module_id, "DECIPHER", "consumed/cipher{:>6} / {:<6} {}\n", module_id, consumed,
@@ -264,7 +280,4 @@ void Frame::log_decipher() const noexcept {
   }
 }
 
-// class data
-ptrdiff_t Frame::cipher_buff_size{0x00};
-
 } // namespace pierre
@@ -0,0 +1,125 @@
+//  Pierre - Custom Light Show for Wiss Landing
+//  Copyright (C) 2022  Tim Hughey
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//  https://www.wisslanding.com
+
+#include "frame/frame_pool.hpp"
+#include "lcs/stats.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+namespace pierre {
+
+namespace {
+
+struct alignas(FramePool::SLOT_ALIGN) slot_storage {
+  std::byte mem[FramePool::SLOT_BYTES];
+};
+
+// the free list is a (Treiber) stack of slot indexes.  the top of the stack
+// is tagged (upper 32 bits) and the tag is bumped on every change so a slot
+// popped and pushed while another thread is mid pop can not be mistaken (ABA)
+struct slab {
+  static constexpr uint64_t IDX_MASK{0xffffffff};
+  static constexpr uint64_t TAG_ONE{IDX_MASK + 1};
+
+  slab() noexcept {
+    for (uint32_t i = 0; i < FramePool::SLOTS; ++i) {
+      next[i].store((i + 1) < FramePool::SLOTS ? i + 1 : FramePool::NO_SLOT);
+    }
+
+    top.store(0);
+  }
+
+  std::array<slot_storage, FramePool::SLOTS> slots;
+  std::array<std::atomic<uint32_t>, FramePool::SLOTS> next;
+  std::atomic<uint32_t> free_count{FramePool::SLOTS};
+  alignas(64) std::atomic<uint64_t> top;
+};
+
+// static storage (bss), constructed on first use
+slab &the_slab() noexcept {
+  static slab s;
+
+  return s;
+}
+
+} // namespace
+
+// Frame (reference count reached zero)
+
+void Frame::recycle(Frame *f) noexcept {
+  const auto slot = f->slot;
+
+  f->~Frame();
+
+  if (slot == FramePool::NO_SLOT) {
+    ::operator delete(f, std::align_val_t{FramePool::SLOT_ALIGN});
+  } else {
+    FramePool::push(slot);
+  }
+}
+
+// FramePool
+
+uint32_t FramePool::available() noexcept {
+  return the_slab().free_count.load(std::memory_order_relaxed);
+}
+
+void *FramePool::heap_alloc() noexcept {
+  Stats::write(stats::FRAME_POOL_HEAP, true);
+
+  return ::operator new(SLOT_BYTES, std::align_val_t{SLOT_ALIGN});
+}
+
+uint32_t FramePool::pop() noexcept {
+  auto &s = the_slab();
+  auto top = s.top.load(std::memory_order_acquire);
+
+  for (;;) {
+    const uint32_t idx = top & slab::IDX_MASK;
+    if (idx == NO_SLOT) return NO_SLOT;
+
+    const uint64_t next_top =
+        ((top & ~slab::IDX_MASK) + slab::TAG_ONE) | s.next[idx].load(std::memory_order_relaxed);
+
+    if (s.top.compare_exchange_weak(top, next_top, std::memory_order_acq_rel,
+                                    std::memory_order_acquire)) {
+      s.free_count.fetch_sub(1, std::memory_order_relaxed);
+      return idx;
+    }
+  }
+}
+
+void FramePool::push(uint32_t slot) noexcept {
+  auto &s = the_slab();
+  auto top = s.top.load(std::memory_order_relaxed);
+  uint64_t next_top;
+
+  do {
+    s.next[slot].store(top & slab::IDX_MASK, std::memory_order_relaxed);
+    next_top = ((top & ~slab::IDX_MASK) + slab::TAG_ONE) | slot;
+  } while (!s.top.compare_exchange_weak(top, next_top, std::memory_order_release,
+                                        std::memory_order_relaxed));
+
+  s.free_count.fetch_add(1, std::memory_order_relaxed);
+}
+
+void *FramePool::slot_ptr(uint32_t slot) noexcept { return the_slab().slots[slot].mem; }
+
+} // namespace pierre
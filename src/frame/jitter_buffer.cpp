@@ -0,0 +1,123 @@
+//  Pierre - Custom Light Show for Wiss Landing
+//  Copyright (C) 2022  Tim Hughey
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//  https://www.wisslanding.com
+
+#include "frame/jitter_buffer.hpp"
+
+#include <algorithm>
+#include <memory>
+
+namespace pierre {
+
+int64_t JitterBuffer::apply_flush() noexcept {
+  // take ownership of the pending request (if any)
+  std::unique_ptr<pending_flush> pf(pending.exchange(nullptr, std::memory_order_acq_rel));
+
+  if (!pf) return -1;
+
+  auto h = head.load(std::memory_order_relaxed);
+  const auto until = std::min(pf->until, tail.load(std::memory_order_acquire));
+
+  int64_t flushed{0};
+
+  // frames are in seq_num order so the flush ends at the first frame that
+  // does not match the request
+  for (; h < until; ++h) {
+    auto &slot = slots[h & MASK];
+
+    if (!slot) continue; // gap, nothing to flush
+    if (!pf->info(slot)) break;
+
+    slot->flushed(); // a frame held by Dsp is skipped rather than processed
+    slot.reset();
+    ++flushed;
+  }
+
+  head.store(h, std::memory_order_release);
+
+  return flushed;
+}
+
+void JitterBuffer::flush(const FlushInfo &request) noexcept {
+  auto next = std::make_unique<pending_flush>(request, tail.load(std::memory_order_acquire));
+
+  // the consumer has not applied the previous request, fold it into this one.
+  // note: the newest seq_num/timestamp criteria wins, flush all is sticky
+  if (std::unique_ptr<pending_flush> prev(pending.exchange(nullptr, std::memory_order_acq_rel));
+      prev) {
+    next->info.all = next->info.all || prev->info.all;
+  }
+
+  pending.store(next.release(), std::memory_order_release);
+
+  // frames that follow a flush (e.g. a seek) may be anywhere relative to the
+  // frames that preceded it
+  rebase.store(true, std::memory_order_release);
+}
+
+frame_t JitterBuffer::peek() noexcept {
+  auto h = head.load(std::memory_order_relaxed);
+  const auto t = tail.load(std::memory_order_acquire);
+
+  // skip gaps (seq_nums never received, discarded or failed decode)
+  while ((h < t) && !slots[h & MASK]) ++h;
+
+  head.store(h, std::memory_order_release);
+
+  return (h < t) ? slots[h & MASK] : frame_t();
+}
+
+JitterBuffer::push_rc JitterBuffer::push(frame_t frame) noexcept {
+  const auto seq_num = frame->seq_num;
+  const auto t = tail.load(std::memory_order_relaxed); // owned by producer
+  const auto h = head.load(std::memory_order_acquire);
+
+  // the ring is full, not even a re-based frame fits
+  if ((t - h) >= static_cast<idx_t>(CAPACITY)) return OVERFLOW;
+
+  auto rc = PUSHED;
+  auto idx = t;
+
+  // at start of play or after a flush re-base so the frame lands at tail
+  // regardless of any jump in seq_num.  otherwise seq_num is relative to the
+  // newest racked frame, even when the ring has drained (a straggler or
+  // retransmit of a consumed frame is late, not a new base)
+  if (!rebase.exchange(false, std::memory_order_acq_rel)) {
+    const auto diff = seq_diff(seq_num, last_seq);
+
+    if (diff <= 0) return LATE; // duplicate or arrived after a later seq_num
+
+    if (diff >= CAPACITY) {
+      rc = DISCONTINUITY; // the sender jumped ahead, re-base at tail
+    } else {
+      idx = last_idx + diff;
+
+      if ((idx - h) >= static_cast<idx_t>(CAPACITY)) return OVERFLOW;
+    }
+  }
+
+  // slots below head are always empty (consumed, flushed or gaps)
+  slots[idx & MASK] = std::move(frame);
+  last_seq = seq_num;
+  last_idx = idx;
+
+  tail.store(idx + 1, std::memory_order_release); // publish to consumer
+
+  return rc;
+}
+
+} // namespace pierre
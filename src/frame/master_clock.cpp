@@ -24,8 +24,10 @@
 #include "base/uint8v.hpp"
 #include "io/io.hpp"
 #include "lcs/config.hpp"
+#include "lcs/stats.hpp"
 
 #include <algorithm>
+#include <cstring>
 #include <errno.h>
 #include <fcntl.h>
 #include <iterator>
@@ -39,15 +41,18 @@ namespace pierre {
 
 // create the MasterClock
 MasterClock::MasterClock() noexcept
-    : guard(io_ctx.get_executor()),                                     // syncronize clock io
-      socket(io_ctx, ip_udp::v4()),                                     // construct and open
-      remote_endpoint(asio::ip::make_address(LOCALHOST), CTRL_PORT),    // nqptp endpoint
-      shm_name(config_val2<MasterClock, string>("shm_name", "/nqptp")), //
-      thread_count(config_threads<MasterClock>(1)),                     //
-      shutdown_latch(std::make_shared<std::latch>(thread_count))        //
+    : guard(io_ctx.get_executor()),                                       // syncronize clock io
+      refresh_timer(io_ctx),                                              // snapshot refresh
+      socket(io_ctx, ip_udp::v4()),                                       // construct and open
+      remote_endpoint(asio::ip::make_address(LOCALHOST), CTRL_PORT),      // nqptp endpoint
+      shm_name(config_val2<MasterClock, string>("shm_name", "/nqptp")),   //
+      thread_count(config_threads<MasterClock>(1)),                       //
+      refresh_interval(config_val2<MasterClock, int>("refresh_ms", 122)), //
+      shutdown_latch(std::make_shared<std::latch>(thread_count))          //
 {
-  INFO_INIT("sizeof={:>4} shm_name={} dest={}:{}\n", sizeof(MasterClock), shm_name,
-            remote_endpoint.address().to_string(), remote_endpoint.port());
+  INFO_INIT("sizeof={:>4} shm_name={} dest={}:{} refresh={}\n", sizeof(MasterClock), shm_name,
+            remote_endpoint.address().to_string(), remote_endpoint.port(),
+            pet::humanize(refresh_interval));
 
   auto latch = std::make_unique<std::latch>(thread_count);
 
@@ -68,6 +73,9 @@ MasterClock::MasterClock() noexcept
   latch->wait(); // caller waits until all threads are started
 
   peers(Peers()); // reset the peers (creates the shm name)}
+
+  // begin sampling nqptp (after peers, which creates the shm)
+  asio::post(io_ctx, [this]() { refresh(); });
 }
 
 MasterClock::~MasterClock() noexcept {
@@ -76,7 +84,14 @@ MasterClock::~MasterClock() noexcept {
   INFO_SHUTDOWN_REQUESTED();
 
   guard.reset();
-  if (is_mapped()) munmap(mapped, sizeof(nqptp));
+
+  // cancel on the io_ctx so a refresh in progress doesn't rearm the timer
+  asio::post(io_ctx, [this]() {
+    try {
+      refresh_timer.cancel();
+    } catch (...) {
+    }
+  });
 
   try {
     socket.close();
@@ -84,11 +99,13 @@ MasterClock::~MasterClock() noexcept {
   }
 
   shutdown_latch->wait();
+
+  if (is_mapped()) munmap(mapped, sizeof(nqptp));
   INFO_SHUTDOWN_COMPLETE();
 }
 
 // NOTE: new data is available every 126ms
-const ClockInfo MasterClock::load_info_from_mapped() {
+const ClockInfo MasterClock::load_info_from_mapped() noexcept {
   static constexpr csv fn_id{"load_mapped"};
 
   if (map_shm() == false) {
@@ -108,28 +125,100 @@ const ClockInfo MasterClock::load_info_from_mapped() {
 
   nqptp data;
   memcpy(&data, (char *)mapped, sizeof(nqptp));
-  if (data.version != NQPTP_VERSION) {
-    static string msg;
-    fmt::format_to(std::back_inserter(msg), "nqptp version mismatch vsn={}", data.version);
-    INFO_AUTO("FATAL {}\n", msg);
-    throw(std::runtime_error(msg.c_str()));
-  }
 
   // release the mutex
   pthread_mutex_unlock(mtx);
   pthread_setcancelstate(prev_state, nullptr);
 
+  // called by the refresher (noexcept), an incompatible nqptp is reported
+  // and treated as no clock
+  if (data.version != NQPTP_VERSION) {
+    static bool reported = false;
+    if (!reported) {
+      INFO_AUTO("nqptp version mismatch vsn={} want={}\n", data.version, NQPTP_VERSION);
+      reported = true;
+    }
+
+    return ClockInfo();
+  }
+
   // find the clock IP string
   string_view clock_ip_sv = string_view(data.master_clock_ip, sizeof(nqptp::master_clock_ip));
   auto trim_pos = clock_ip_sv.find_first_of('\0');
   clock_ip_sv.remove_suffix(clock_ip_sv.size() - trim_pos);
 
+  Stats::write(stats::CLOCK_OFFSET, static_cast<int64_t>(data.local_to_master_time_offset));
+
   return ClockInfo(data.master_clock_id, string(clock_ip_sv),
                    data.local_time,                  // aka sample time
                    data.local_to_master_time_offset, // aka raw offset
                    pet::from_val<Nanos>(data.master_clock_start_time));
 }
 
+void MasterClock::refresh() noexcept {
+  // only the refresher shares (serialized by the timer chain)
+  share(load_info_from_mapped());
+
+  if (!guard.owns_work()) return; // shutting down
+
+  refresh_timer.expires_after(refresh_interval);
+  refresh_timer.async_wait([this](const error_code ec) {
+    if (!ec) refresh();
+  });
+}
+
+void MasterClock::share(const ClockInfo &info) noexcept {
+  std::array<uint64_t, IP_WORDS> ip{};
+  const auto &ip_str = info.masterClockIp;
+  std::memcpy(ip.data(), ip_str.data(), std::min(ip_str.size(), sizeof(ip) - 1));
+
+  const auto seq = shared_seq.load(std::memory_order_relaxed);
+
+  shared_seq.store(seq + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  shared_clock_id.store(info.clock_id, std::memory_order_relaxed);
+  for (size_t i = 0; i < IP_WORDS; i++) {
+    shared_ip[i].store(ip[i], std::memory_order_relaxed);
+  }
+  shared_sample_time.store(info.sampleTime, std::memory_order_relaxed);
+  shared_raw_offset.store(info.rawOffset, std::memory_order_relaxed);
+  shared_start_time.store(info.mastershipStartTime.count(), std::memory_order_relaxed);
+
+  shared_seq.store(seq + 2, std::memory_order_release);
+}
+
+ClockInfo MasterClock::snapshot() const noexcept {
+  for (;;) {
+    const auto seq = shared_seq.load(std::memory_order_acquire);
+
+    if ((seq & 1) == 0) {
+      const auto clock_id = shared_clock_id.load(std::memory_order_relaxed);
+
+      std::array<uint64_t, IP_WORDS> ip;
+      for (size_t i = 0; i < IP_WORDS; i++) {
+        ip[i] = shared_ip[i].load(std::memory_order_relaxed);
+      }
+
+      const auto sample_time = shared_sample_time.load(std::memory_order_relaxed);
+      const auto raw_offset = shared_raw_offset.load(std::memory_order_relaxed);
+      const auto start_time = shared_start_time.load(std::memory_order_relaxed);
+
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (shared_seq.load(std::memory_order_relaxed) == seq) {
+        if (clock_id == 0) return ClockInfo(); // nqptp not available (yet)
+
+        const auto *ip_chars = reinterpret_cast<const char *>(ip.data());
+
+        return ClockInfo(clock_id, MasterIP(ip_chars, strnlen(ip_chars, sizeof(ip))), sample_time,
+                         raw_offset, Nanos(start_time));
+      }
+    }
+
+    std::this_thread::yield(); // refresh() is sharing
+  }
+}
+
 bool MasterClock::map_shm() {
   static constexpr csv fn_id{"map_shm"};
   int prev_state;
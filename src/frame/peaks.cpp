@@ -17,7 +17,6 @@
 // https://www.wisslanding.com
 
 #include "peaks.hpp"
-#include "lcs/config.hpp"
 #include "peaks/peak_config.hpp"
 
 #include <algorithm>
@@ -27,20 +26,51 @@
 
 namespace pierre {
 
-bool Peaks::emplace(Magnitude m, Frequency f, CHANNEL channel) noexcept {
-  auto rc = false;
-
+void Peaks::select(CHANNEL channel, std::span<const float> mags,
+                   std::span<const float> freqs) noexcept {
   const auto ml = PeakConfig::mag_limits();
+  const double mag_min = ml.min();
+  const double mag_max = ml.max();
 
-  auto &map = peaks_map[channel];
-
-  if ((m >= ml.min()) && (m <= ml.max())) {
-    auto node = map.try_emplace(m, f, m);
+  // candidates within limits (branch free)
+  std::array<uint16_t, MAX_CANDIDATES> order;
+  size_t n = 0;
 
-    rc = node.second; // was the peak inserted?
+  for (size_t i = 0; i < std::min(mags.size(), MAX_CANDIDATES); i++) {
+    order[n] = i;
+    n += (mags[i] >= mag_min) & (mags[i] <= mag_max);
   }
 
-  return rc;
+  // partial selection of the largest magnitudes, ties keep the first candidate
+  const auto first = order.begin();
+  const auto want = first + std::min(n, CAPACITY);
+
+  std::partial_sort(first, want, first + n, [&mags](uint16_t a, uint16_t b) {
+    return (mags[a] > mags[b]) || ((mags[a] == mags[b]) && (a < b));
+  });
+
+  auto &p = peaks[channel];
+  p.count = 0;
+  p.found = n;
+
+  for (auto it = first; it != want; ++it) {
+    const auto i = *it;
+
+    // a magnitude is only recorded once (first candidate wins)
+    if (p.count && (mags[i] == p.mag[p.count - 1])) {
+      --p.found;
+      continue;
+    }
+
+    const Frequency f(freqs[i]);
+    const Magnitude m(mags[i]);
+
+    p.freq[p.count] = freqs[i];
+    p.mag[p.count] = mags[i];
+    p.freq_scaled[p.count] = f.scaled();
+    p.mag_scaled[p.count] = m.scaled();
+    ++p.count;
+  }
 }
 
 } // namespace pierre
@@ -24,20 +24,24 @@ namespace pierre {
 
 // static member data
 
-mag_min_max PeakConfig::mag_limits() noexcept {
+// defaults
+static constexpr double mag_floor{2.1};
+static constexpr double mag_ceiling{32.0};
 
-  // defaults
-  static const Magnitude floor(2.1);
-  static const Magnitude ceiling(32.0);
+// resolved once and refreshed when the config file changes (read per frame)
+static ConfigValue<mag_min_max> mag_limits_cfg(
+    []() {
+      static const toml::path path{"frame.peaks.magnitudes"sv};
 
-  static const toml::path path{"frame.peaks.magnitudes"sv};
+      if (const auto mags = config()->table_at(path); mags) {
+        return mag_min_max(mags["floor"sv].value_or<double>(mag_floor), //
+                           mags["ceiling"sv].value_or<double>(mag_ceiling));
+      }
 
-  if (const auto mags = config()->table_at(path); mags) {
-    return mag_min_max(mags["floor"sv].value_or<double>(floor), //
-                       mags["ceiling"sv].value_or<double>(ceiling));
-  }
+      return mag_min_max(mag_floor, mag_ceiling);
+    },
+    mag_min_max(mag_floor, mag_ceiling));
 
-  return mag_min_max(floor, ceiling);
-}
+mag_min_max PeakConfig::mag_limits() noexcept { return mag_limits_cfg(); }
 
-} // namespace pierre
\ No newline at end of file
+} // namespace pierre
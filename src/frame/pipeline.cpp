@@ -0,0 +1,63 @@
+//  Pierre - Custom Light Show for Wiss Landing
+//  Copyright (C) 2022  Tim Hughey
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//  https://www.wisslanding.com
+
+#include "frame/pipeline.hpp"
+#include "base/thread_util.hpp"
+#include "lcs/config.hpp"
+#include "lcs/logger.hpp"
+#include "lcs/stats.hpp"
+
+#include <cstring>
+#include <fmt/format.h>
+
+namespace pierre {
+namespace pipeline {
+
+// NOTE: .cpp required to hide config.hpp and stats.hpp from pipeline.hpp
+
+static constexpr csv module_id{"frame.pipeline"};
+
+void stage_thread_init(const char *stage, int num) noexcept {
+  static constexpr csv fn_id{"stage"};
+  const auto thread_name = thread_util::set_name(stage, num);
+
+  const auto cpu_path = fmt::format("{}.cpu.{}", module_id, stage);
+
+  if (const auto cpu = config_val<int>(cpu_path, -1); cpu >= 0) {
+    if (const auto rc = thread_util::set_affinity(cpu); rc) {
+      INFO_AUTO("{} cpu={} affinity failed, {}\n", thread_name, cpu, std::strerror(rc));
+    }
+  }
+
+  INFO_THREAD_START();
+}
+
+void record_depth(const char *stage, size_t depth) noexcept {
+  Stats::write(stats::PIPELINE_DEPTH, depth, std::make_pair("stage", stage));
+}
+
+void record_dropped(const char *stage) noexcept {
+  Stats::write(stats::PIPELINE_DROPPED, true, std::make_pair("stage", stage));
+}
+
+void record_latency(const char *stage, Nanos latency) noexcept {
+  Stats::write(stats::PIPELINE_LATENCY, latency, std::make_pair("stage", stage));
+}
+
+} // namespace pipeline
+} // namespace pierre
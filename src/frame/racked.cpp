@@ -28,6 +28,7 @@
 #include "io/io.hpp"
 #include "lcs/config.hpp"
 #include "lcs/stats.hpp"
+#include "lcs/trace.hpp"
 #include "master_clock.hpp"
 #include "silent_frame.hpp"
 
@@ -36,25 +37,18 @@
 #include <atomic>
 #include <latch>
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <ranges>
-#include <set>
 #include <stop_token>
 #include <vector>
 
 namespace pierre {
 
-// static class data
-int64_t Racked::REEL_SERIAL_NUM{0x1000};
-
 Racked::Racked(MasterClock *master_clock) noexcept
     : thread_count(config_threads<Racked>(3)), // thread count
       guard(asio::make_work_guard(io_ctx)),    // ensure io_ctx has work
-      handoff_strand(io_ctx),                  // unprocessed frame 'queue'
-      wip_strand(io_ctx),                      // guard work in progress reeel
-      frame_strand(io_ctx),                    // used for next frame
-      flush_strand(io_ctx),                    // isolate flush (and interrupt other strands)
-      wip_timer(io_ctx),                       // rack incomplete wip reels
+      flush_strand(io_ctx),                    // serialize flush requests
       master_clock(master_clock)               // inject master clock dependency
 {
 
@@ -83,6 +77,11 @@ Racked::Racked(MasterClock *master_clock) noexcept
 
   latch->wait(); // caller waits until all threads are started
 
+  // pipeline stages, each with a dedicated thread (started last since they
+  // call Av and rack frames)
+  decode_stage.emplace("decode", -1, [this](deciphered_t &in) { decode(in); });
+  decipher_stage.emplace("decipher", -1, [this](ingest_t &in) { decipher(in); });
+
   ready = true;
 }
 
@@ -90,10 +89,16 @@ Racked::~Racked() noexcept {
 
   INFO_SHUTDOWN_REQUESTED();
 
-  guard.reset();
+  // stop the pipeline from the ingest side so no stage pushes to a stopped stage
+  {
+    std::lock_guard lck(ingest_mtx);
+    ready = false;
+    decipher_stage.reset();
+  }
 
-  [[maybe_unused]] error_code ec;
-  wip_timer.cancel(ec);
+  decode_stage.reset();
+
+  guard.reset();
 
   shutdown_latch->wait();
 
@@ -102,303 +107,190 @@ Racked::~Racked() noexcept {
   INFO_SHUTDOWN_COMPLETE();
 }
 
+void Racked::audio_format(uint64_t ct) noexcept {
+  // configure is serialized with decoding, applied before the next frame is decoded
+  pending_ct.store(ct);
+}
+
 void Racked::flush(FlushInfo &&request) {
   static constexpr csv fn_id{"flush"};
 
   asio::post(flush_strand, [this, request = std::move(request)]() mutable {
     INFO_AUTO("{}\n", request);
 
-    // record the flush request to check incoming frames (guarded by flush_strand)
-    flush_request = std::move(request);
-
-    // flush wip first so we can unlock it quickly
-    if (wip.has_value()) {
-      // lock both the wip and rack
-      std::unique_lock lck_wip(wip_mtx, std::defer_lock);
-      lck_wip.lock();
-
-      // if wip is completely flushed reset the optional
-      if (wip->flush(flush_request)) {
-        [[maybe_unused]] error_code ec;
-        wip_timer.cancel(ec);
-        wip.reset();
-      }
-    }
-
-    std::unique_lock lck_rack{rack_mtx, std::defer_lock};
-    lck_rack.lock();
-
-    // now, to optimize the flush, let's first check if everything racked
-    // is within the request.  if so, we can simply clear all racked reels
-    auto initial_size = std::ssize(racked);
-    if (initial_size > 0) {
-
-      auto first = racked.begin()->second.peek_first();
-      auto last = racked.rbegin()->second.peek_last();
-
-      INFO_AUTO("rack contains seq_num {:<8}/{:>8} before flush\n", first->seq_num, last->seq_num);
+    std::lock_guard lck(flush_mtx);
 
-      if (flush_request.matches<frame_t>({first, last})) {
-        // yes, the entire rack matches the flush request so we can
-        // take a short-cut and clear the entire rack in oneshot
-        INFO_AUTO("clearing all reels={}\n", initial_size);
+    // frames queued (ingested before this request) are checked against it
+    // again when deciphered and when racked, see stale()
+    flush_latest = FlushInfo(request);
+    flush_count.fetch_add(1, std::memory_order_relaxed);
 
-        racked_reels cleared;
-        std::swap(racked, cleared);
-
-      } else {
-        // the entire rack did not match the flush request so now
-        // we must use maximum effort and look at each reel
-
-        for (auto it = racked.begin(); it != racked.end();) {
-          auto &reel = it->second;
-
-          if (reel.flush(flush_request)) { // true=reel empty
-            it = racked.erase(it);         // returns it to next not erased entry
-            Stats::write(stats::RACKED_REELS, std::ssize(racked));
-          } else {
-            INFO_AUTO("KEEPING {}\n", reel);
-          }
-        }
-      }
-
-      const auto flushed = initial_size - std::ssize(racked);
-      Stats::write(stats::REELS_FLUSHED, int64_t{flushed > 0 ? flushed : initial_size});
-    }
+    // record the flush request to check incoming frames
+    flush_request = std::move(request);
 
-    // has everything been flushed?
-    if (racked.empty() && !wip) {
-      first_frame.reset(); // signal we're starting fresh
-    }
+    // hand the request to the jitter buffer, it is applied by the consumer
+    // (next_frame) so neither decode nor render ever wait on a flush.  under
+    // flush_mtx so a frame decode racks was either checked against this
+    // request or is racked before the jitter buffer applies it
+    racked.flush(flush_request);
   });
 }
 
-void Racked::handoff(uint8v &&packet, const uint8v &key) noexcept {
-  if (ready.load() == false) return; // quietly ignore packets when Racked is not ready
-  if (packet.empty()) return;        // quietly ignore empty packets
-
-  auto frame = Frame::create(packet); // create frame, will also be moved in lambda (as needed)
+void Racked::decipher(ingest_t &in) noexcept {
+  auto frame = Frame::create(in.packet);
 
   if (frame->state.header_parsed()) {
-    if (flush_request.should_flush(frame)) {
+    auto flushed = false;
+
+    {
+      std::lock_guard lck(flush_mtx);
+      flushed = stale(frame, in.flushes) || flush_request.should_flush(frame);
+    }
+
+    if (flushed) {
       frame->flushed();
-    } else if (frame->decipher(std::move(packet), key)) {
-      // notes:
-      //  1. we post to handoff_strand to control the concurrency of decoding
-      //  2. we move the packet since handoff() is done with it
-      //  3. we grab a reference to handoff strand since we move s
-      //  4. we move the frame since no code beyond this point needs it
-
-      asio::post(handoff_strand, [this, frame = std::move(frame)]() {
-        // here we do the decoding of the audio data, if decode succeeds we
-        // rack the frame into wip
-
-        if (frame->decode(av.get())) [[likely]] {
-          // decode success, rack the frame
-
-          // we post to wip_strand to guard wip reel.  that said, we still use a mutex
-          // because of flushing and so next_frame can temporarily interrupt inbound
-          // decoded packet spooling.  this is important because once a wip is full it
-          // must be spooled into racked reels which is also being read from for next_frame()
-          asio::post(wip_strand, [this, frame = std::move(frame)]() mutable {
-            std::unique_lock lck(wip_mtx, std::defer_lock);
-            lck.lock();
-
-            // create the wip, if needed
-            if (wip.has_value() == false) wip.emplace(++REEL_SERIAL_NUM);
-
-            wip->add(frame);
-
-            if (wip->full()) {
-              rack_wip();
-            } else if (std::ssize(*wip) == 1) {
-              monitor_wip(); // handle incomplete wip reels
-            }
-          });
-
-        } else {
-          frame->state.record_state(); // save the failue to timeseries database
-        }
-      });
+    } else if (frame->decipher(std::move(in.packet), *in.key)) {
+      // wait when the decode queue is full, the decipher queue absorbs the backlog
+      decode_stage->push(std::move(frame), in.flushes);
     }
   } else {
     frame->state.record_state();
   }
 }
 
-void Racked::monitor_wip() noexcept {
-  static constexpr csv fn_id{"monitor_wip"};
-
-  wip_timer.expires_from_now(10s);
-
-  wip_timer.async_wait( // must run on wip_strand to protect containers
-      asio::bind_executor(wip_strand, [this, serial_num = wip->serial_num()](const error_code ec) {
-        // note: serial_num is captured to ensure the same wip reel is active when
-        //       the timer fires
-
-        if (!ec && !racked.contains(serial_num)) {
-          INFOX(module_id, fn_id, "INCOMPLETE {}\n", wip->inspect());
-          Stats::write(stats::RACK_WIP_INCOMPLETE, wip->size());
-          // not a timer error and reel is the same
-          rack_wip();
-        } else if (!ec) {
-          INFO_AUTO("reel serial_num={} already racked\n", serial_num);
-        }
-      }));
-}
-
-frame_future Racked::next_frame() noexcept { // static
-  auto prom = frame_promise();
-  auto fut = prom.get_future().share();
+void Racked::decode(deciphered_t &in) noexcept {
+  auto &frame = in.frame;
 
-  // when Racked isn't ready (doesn't exist) return SilentFrame
-  if (ready.load() == false) {
-    prom.set_value(SilentFrame::create());
-    return fut;
+  // the decode stage is the only caller of Av (configure and parse)
+  if (pending_ct.load(std::memory_order_relaxed) != CT_NONE) {
+    av->configure(pending_ct.exchange(CT_NONE));
   }
 
-  asio::post(frame_strand, [this, prom = std::move(prom)]() mutable {
-    std::unique_lock lck{rack_mtx, std::defer_lock}; // don't lock yet
+  // here we do the decoding of the audio data, if decode succeeds we
+  // rack the frame
 
-    // do we have any racked reels? if not, return a SilentFrame
-    lck.lock(); // guard std::empty(racked) call
-    if (std::empty(racked)) {
-      prom.set_value(SilentFrame::create());
+  if (frame->decode(av.get())) [[likely]] {
+    const auto seq_num = frame->seq_num;
+
+    // a flush recorded while the frame was queued for decode applies too
+    std::unique_lock lck(flush_mtx);
+    if (stale(frame, in.flushes)) {
+      frame->flushed();
       return;
     }
 
-    // we have racked reels but need clock_info, unlock while we wait
+    const auto rc = racked.push(frame);
     lck.unlock();
 
-    auto master_clock_fut = master_clock->info();
-    auto clock_info = ClockInfo();
-
-    if (master_clock_fut.valid()) {
-      auto master_clock_result = master_clock_fut.wait_for(InputInfo::lead_time_min);
-      if (master_clock_result == std::future_status::ready) {
-        clock_info = master_clock_fut.get();
-      }
+    if (!JitterBuffer::racked(rc)) {
+      Stats::write(stats::RACK_DROPPED, true);
+    } else {
+      Trace::instant(trace::RACKED, seq_num);
     }
 
-    if (clock_info.ok() == false) {
-      // no clock info, set promise to SilentFrame
-      prom.set_value(SilentFrame::create());
-    } else [[likely]] {
-      // we have ClockInfo and there are racked reels
-      // refresh clock info and get anchor info
-      clock_info = master_clock->info().get();
-      auto anchor = Anchor::get_data(clock_info);
-
-      // anchor not ready yet or we haven't been instructed to spool
-      // so set the promise to a SilentFrame. (i.e. user hit pause, hasn't hit
-      // play yet or disconnected)
-      //
-      // note:  we could have done this check very early and completely avoid
-      // the asio::post but didn't so we could prime ClockInfo and Anchor.
-      // plus the above code isn't really that expensive every ~23ms.
-      if ((anchor.ready() == false) || !spool_frames) {
-        prom.set_value(SilentFrame::create());
-        return;
-      }
+    log_racked(rc);
 
-      lck.lock(); // lock since since we're looking at racked reels
+  } else {
+    frame->state.record_state(); // save the failue to timeseries database
+  }
+}
 
-      auto &reel = racked.begin()->second; // avoid multiple begin()->second
-      auto frame = reel.peek_first();
+void Racked::handoff(uint8v &&packet, std::shared_ptr<const uint8v> key) noexcept {
+  if (packet.empty()) return; // quietly ignore empty packets
 
-      // calc the frame state (Frame caches the anchor)
-      auto state = frame->state_now(anchor, InputInfo::lead_time);
-      prom.set_value(frame);
+  std::lock_guard lck(ingest_mtx);
 
-      if (state.ready() || state.outdated() || state.future()) {
-        // consume the ready or outdated frame
-        reel.consume();
+  if (ready.load() == false) return; // quietly ignore packets when Racked is not ready
 
-        // if the reel is empty, discard it
-        if (reel.empty()) {
-          racked.erase(racked.begin());
-          Stats::write(stats::RACKED_REELS, std::ssize(racked));
-        }
+  // never wait here, the ingest thread must keep reading the socket
+  decipher_stage->push_or_drop(std::move(packet), std::move(key),
+                               flush_count.load(std::memory_order_relaxed));
+}
 
-        log_racked();
-      }
-    }
-  });
+frame_future Racked::next_frame() noexcept {
+  auto prom = frame_promise();
+  auto fut = prom.get_future().share();
+
+  prom.set_value(next_frame_impl());
 
-  // return the future
   return fut;
 }
 
-void Racked::rack_wip() noexcept {
-  [[maybe_unused]] error_code ec;
-  wip_timer.cancel(ec); // wip reel is full, cancel the incomplete spool timer
+frame_t Racked::next_frame_impl() noexcept {
+  static constexpr csv fn_id{"next_frame"};
 
-  log_racked_rc rc{NONE};
+  // when Racked isn't ready (doesn't exist) return SilentFrame
+  if (ready.load() == false) return SilentFrame::create();
 
-  std::unique_lock lck{rack_mtx, std::defer_lock};
-  if (!wip->empty()) {
+  // apply any flush request recorded since the previous call
+  if (const auto flushed = racked.apply_flush(); flushed >= 0) {
+    INFO_AUTO("flushed={} {}\n", flushed, racked);
+    Stats::write(stats::FRAMES_FLUSHED, flushed);
+  }
 
-    if (lck.try_lock_for(InputInfo::lead_time)) [[likely]] {
+  // do we have any racked frames? if not, return a SilentFrame
+  auto frame = racked.peek();
+  if (!frame) return SilentFrame::create();
 
-      // get a copy of serial_num since emplace moving can be unpredictable
-      const auto serial_num = wip->serial_num();
+  // latest clock info (a sequence lock copy, retries only when it overlaps a
+  // refresh in the background)
+  const auto clock_info = master_clock->snapshot();
 
-      auto it = racked.try_emplace( //
-          racked.cend(),            // hint: at end
-          serial_num,               // key: serial num,
-          std::move(wip.value()));
+  // no clock info, return a SilentFrame
+  if (clock_info.ok() == false) return SilentFrame::create();
 
-      rc = it->first == serial_num ? RACKED : COLLISION;
+  // we have ClockInfo and there are racked frames, get anchor info
+  auto anchor = Anchor::get_data(clock_info);
 
-    } else {
-      rc = TIMEOUT;
-    }
+  // anchor not ready yet or we haven't been instructed to spool
+  // so return a SilentFrame. (i.e. user hit pause, hasn't hit
+  // play yet or disconnected)
+  if ((anchor.ready() == false) || !spool_frames) return SilentFrame::create();
 
-    if (rc == COLLISION) {
-      Stats::write(stats::RACK_COLLISION, true);
-    } else if (rc == RACKED) {
-      Stats::write(stats::RACKED_REELS, std::ssize(racked));
-    } else if (rc == TIMEOUT) {
-      Stats::write(stats::RACK_WIP_TIMEOUT, true);
-    }
+  // calc the frame state (Frame caches the anchor)
+  auto state = frame->state_now(anchor, InputInfo::lead_time);
 
-    log_racked(rc);
+  if (state.ready() || state.outdated() || state.future()) {
+    // consume the ready or outdated frame
+    racked.consume();
+    Trace::instant(trace::DEQUEUED, frame->seq_num);
 
-    // regardless of the outcome above, reset wip
-    wip.reset();
+    Stats::write(stats::RACKED_FRAMES, racked.size());
+    log_racked();
   }
+
+  return frame;
 }
 
-void Racked::log_racked(log_racked_rc rc) const noexcept {
+void Racked::log_racked(JitterBuffer::push_rc rc) const noexcept {
   static constexpr csv fn_id{"log_racked"};
 
   if (Logger::should_log(module_id, fn_id)) {
     string msg;
     auto w = std::back_inserter(msg);
 
-    auto reel_count = std::ssize(racked);
+    const auto frame_count = racked.size();
 
     switch (rc) {
-    case log_racked_rc::NONE: {
-      if (reel_count == 0) {
-        auto frame_count = racked.cbegin()->second.size();
-        if (frame_count == 1) fmt::format_to(w, "LAST FRAME");
-      } else if ((reel_count >= 400) && ((reel_count % 10) == 0)) {
-        fmt::format_to(w, "HIGH REELS reels={:<3}", reel_count);
+    case JitterBuffer::PUSHED: {
+      if (frame_count == 0) {
+        fmt::format_to(w, "LAST FRAME");
+      } else if ((frame_count >= (JitterBuffer::CAPACITY - InputInfo::fps)) &&
+                 ((frame_count % 10) == 0)) {
+        fmt::format_to(w, "HIGH FRAMES frames={:<4}", frame_count);
       }
     } break;
 
-    case log_racked_rc::RACKED: {
-      if (reel_count == 1) {
-        fmt::format_to(w, "FIRST REEL reels={:<3}", reel_count);
-      }
+    case JitterBuffer::LATE:
+      fmt::format_to(w, "LATE {}", racked);
+      break;
 
-      if (wip.has_value() && !wip->empty()) {
-        fmt::format_to(w, " wip_reel={}", wip.value());
-      }
-    } break;
+    case JitterBuffer::OVERFLOW:
+      fmt::format_to(w, "OVERFLOW {}", racked);
+      break;
 
-    default:
+    case JitterBuffer::DISCONTINUITY:
+      fmt::format_to(w, "DISCONTINUITY {}", racked);
       break;
     }
 
@@ -406,4 +298,4 @@ void Racked::log_racked(log_racked_rc rc) const noexcept {
   }
 }
 
-} // namespace pierre
\ No newline at end of file
+} // namespace pierre
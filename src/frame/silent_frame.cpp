@@ -17,6 +17,7 @@
 //  https://www.wisslanding.com
 
 #include "frame/silent_frame.hpp"
+#include "frame/frame_pool.hpp"
 
 #include <optional>
 
@@ -33,4 +34,6 @@ namespace pierre {
 Nanos SilentFrame::epoch{pet::now_monotonic()};
 int64_t SilentFrame::frame_num{0};
 
+frame_t SilentFrame::create() noexcept { return FramePool::acquire<SilentFrame>(); }
+
 } // namespace pierre
\ No newline at end of file
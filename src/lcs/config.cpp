@@ -33,6 +33,8 @@
 #include <iostream>
 #include <latch>
 #include <memory>
+#include <mutex>
+#include <set>
 
 namespace pierre {
 
@@ -44,6 +46,45 @@ namespace shared {
 std::unique_ptr<Config> config{nullptr};
 }
 
+namespace {
+// bindings may be created before Config (e.g. file scope statics) so the
+// registry is independent of the Config instance
+struct config_bindings {
+  std::mutex mtx;
+  std::set<ConfigBinding *> all;
+};
+
+config_bindings &bindings() noexcept {
+  static config_bindings b;
+
+  return b;
+}
+} // namespace
+
+// ConfigBinding API
+void ConfigBinding::bind() noexcept {
+  auto &b = bindings();
+  std::unique_lock lck(b.mtx);
+
+  b.all.insert(this);
+}
+
+void ConfigBinding::refresh_all() noexcept { // static
+  auto &b = bindings();
+  std::unique_lock lck(b.mtx);
+
+  for (auto binding : b.all) {
+    binding->refresh();
+  }
+}
+
+void ConfigBinding::unbind() noexcept {
+  auto &b = bindings();
+  std::unique_lock lck(b.mtx);
+
+  b.all.erase(this);
+}
+
 // Config API
 Config::Config(io_context &io_ctx, const toml::table &cli_table) noexcept
     : io_ctx(io_ctx),                           //
@@ -103,6 +144,8 @@ void Config::init() noexcept {
 
     initialized = true;
 
+    ConfigBinding::refresh_all(); // resolve bindings created before config was ready
+
     init_msg = fmt::format("sizeof={:>4} table size={}", //
                            sizeof(Config), tables.front().size());
 
@@ -158,6 +201,7 @@ void Config::monitor_file() noexcept {
       last_write = now_last_write;
 
       parse();
+      ConfigBinding::refresh_all();
 
       std::unique_lock lck(want_changes_mtx, std::defer_lock);
       lck.lock();
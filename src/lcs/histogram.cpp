@@ -0,0 +1,64 @@
+//  Pierre - Custom Light Show for Wiss Landing
+//  Copyright (C) 2022  Tim Hughey
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//  https://www.wisslanding.com
+
+#include "lcs/histogram.hpp"
+
+#include <algorithm>
+
+namespace pierre {
+
+Histogram::summary Histogram::take() noexcept {
+  // move the interval counts out of the live buckets (values recorded while
+  // this runs land in either this interval or the next, never lost)
+  std::array<uint64_t, BUCKETS> interval;
+  summary s;
+
+  for (size_t i = 0; i < BUCKETS; i++) {
+    interval[i] = counts[i].exchange(0, std::memory_order_relaxed);
+    s.count += interval[i];
+  }
+
+  s.negative = negative.exchange(0, std::memory_order_relaxed);
+  s.max = max.exchange(0, std::memory_order_relaxed);
+
+  if (s.count == 0) return s;
+
+  // rank (1 based) of each quantile then a single cumulative pass
+  const auto rank = [n = s.count](double q) {
+    return std::max<uint64_t>(1, static_cast<uint64_t>(q * n + 0.5));
+  };
+
+  const std::array<std::pair<uint64_t, uint64_t *>, 4> quantiles{
+      {{rank(0.50), &s.p50}, {rank(0.90), &s.p90}, {rank(0.99), &s.p99}, {rank(0.999), &s.p999}}};
+
+  uint64_t seen{0};
+  size_t q{0};
+
+  for (size_t i = 0; (i < BUCKETS) && (q < quantiles.size()); i++) {
+    seen += interval[i];
+
+    for (; (q < quantiles.size()) && (seen >= quantiles[q].first); q++) {
+      // never report beyond the actual max (top bucket is clamped)
+      *quantiles[q].second = std::min(midpoint(i), s.max);
+    }
+  }
+
+  return s;
+}
+
+} // namespace pierre
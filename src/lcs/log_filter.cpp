@@ -0,0 +1,110 @@
+//  Pierre - Custom Light Show for Wiss Landing
+//  Copyright (C) 2022  Tim Hughey
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//  https://www.wisslanding.com
+
+#include "lcs/log_filter.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <utility>
+
+namespace pierre {
+
+LogFilter::LogFilter(const toml::table &info) noexcept {
+  // initial size is based on the top level keys, add() grows as needed
+  slots.resize(std::bit_ceil(std::max<size_t>(info.size() * 4, 16)));
+
+  flatten(info, string());
+}
+
+void LogFilter::add(string path, bool val) noexcept {
+  // grow (rare, only for deeply nested tables) to keep the load factor low
+  if (((count + 1) * 2) > slots.size()) {
+    auto old = std::exchange(slots, std::vector<entry>(slots.size() * 2));
+    count = 0;
+
+    for (auto &e : old) {
+      if (!e.path.empty()) add(std::move(e.path), e.val);
+    }
+  }
+
+  const auto mask = slots.size() - 1;
+  const auto hash = fnv(path);
+
+  for (auto i = hash & mask;; i = (i + 1) & mask) {
+    auto &slot = slots[i];
+
+    if (slot.path.empty()) {
+      slot = entry{hash, std::move(path), val};
+      count++;
+      return;
+    }
+
+    if (slot.path == path) return; // first wins (toml keys are unique)
+  }
+}
+
+const LogFilter::entry *LogFilter::find(uint64_t hash, csv a, csv b) const noexcept {
+  if (slots.empty()) return nullptr;
+
+  const auto mask = slots.size() - 1;
+  const auto len = b.empty() ? a.size() : a.size() + 1 + b.size();
+
+  for (auto i = hash & mask;; i = (i + 1) & mask) {
+    const auto &slot = slots[i];
+
+    if (slot.path.empty()) return nullptr; // not present
+
+    if ((slot.hash == hash) && (slot.path.size() == len)) {
+      const csv p{slot.path};
+
+      if (b.empty() && (p == a)) return &slot;
+
+      if (!b.empty() && p.starts_with(a) && (p[a.size()] == '.') && p.ends_with(b)) {
+        return &slot;
+      }
+    }
+  }
+}
+
+void LogFilter::flatten(const toml::table &table, const string &prefix) noexcept {
+  for (auto &&[key, node] : table) {
+    auto path = prefix.empty() ? string(key.str()) : prefix + "." + string(key.str());
+
+    if (node.is_boolean()) {
+      add(std::move(path), node.as_boolean()->get());
+    } else if (node.is_table()) {
+      flatten(*node.as_table(), path);
+    }
+  }
+}
+
+bool LogFilter::should_log(csv mod, csv cat) const noexcept {
+  if (cat == csv{"info"}) return true;
+
+  if (auto e = find(fnv(cat), cat); e) return e->val;
+
+  const auto mod_hash = fnv(mod);
+  if (auto e = find(mod_hash, mod); e) return e->val;
+
+  // hash continues across the dot so no joined string is built
+  if (auto e = find(fnv(cat, fnv(csv{"."}, mod_hash)), mod, cat); e) return e->val;
+
+  return true;
+}
+
+} // namespace pierre
@@ -19,6 +19,7 @@
 #include "lcs/logger.hpp"
 #include "base/thread_util.hpp"
 #include "lcs/config.hpp"
+#include "lcs/log_filter.hpp"
 
 #include <filesystem>
 #include <iostream>
@@ -32,20 +33,95 @@ Logger logger;
 
 namespace fs = std::filesystem;
 
-Logger::Logger() noexcept : guard(asio::make_work_guard(io_ctx)) {}
+Logger::Logger() noexcept
+    : guard(asio::make_work_guard(io_ctx)), // keep io_ctx running until shutdown
+      drain_timer(io_ctx)                   // periodic drain of the ring
+{}
 
-void Logger::print(const string prefix, const string msg) noexcept {
-  if (out.has_value()) {
-    out->print("{} {}", prefix, msg);
-    out->flush();
-  } else {
-    fmt::print(std::cout, "{} {}", prefix, msg);
+void Logger::drain() noexcept {
+  std::unique_lock lck(drain_mtx);
+
+  for (auto *rec = ring.front(); rec; rec = ring.front()) {
+    format_prefix(Nanos(rec->ts), rec->mod_id(), rec->category());
+
+    if (rec->render) {
+      rec->render(rec->fs, rec->payload.data(), batch);
+    } else {
+      const auto text = rec->text();
+      batch.append(text.data(), text.data() + text.size());
+    }
+
+    ring.pop();
+  }
+
+  // report messages dropped because the ring was full (once per drain)
+  if (const auto d = dropped.load(std::memory_order_relaxed); d != dropped_reported) {
+    format_prefix(elapsed_runtime, module_id, csv{"DROPPED"});
+    fmt::format_to(fmt::appender(batch), "messages={} total={}\n", d - dropped_reported, d);
+    dropped_reported = d;
+  }
+
+  write_batch();
+}
+
+void Logger::drain_timer_start() noexcept {
+  drain_timer.expires_after(DRAIN_INTERVAL);
+  drain_timer.async_wait([this](const error_code ec) {
+    drain();
+
+    // once shutting down the caller drains and io_ctx is allowed to stop
+    if (!ec && !shutting_down.load()) drain_timer_start();
+  });
+}
+
+void Logger::format_prefix(Nanos ts, csv mod, csv cat) noexcept {
+  fmt::format_to(fmt::appender(batch), prefix_format,
+                 std::chrono::duration_cast<millis_fp>(ts), // millis since app start
+                 width_ts,                                  // width of timsstap field,
+                 width_ts_precision,                        // runtime + width and precision
+                 mod, width_mod,                            // module_id + width
+                 cat, width_cat);                           // category + width
+  batch.append(SPACE.data(), SPACE.data() + SPACE.size());
+}
+
+void Logger::write_batch() noexcept {
+  if (batch.size() > 0) {
+    const csv text(batch.data(), batch.size());
+
+    if (out.has_value()) {
+      out->print("{}", text);
+    } else {
+      fmt::print(std::cout, "{}", text);
+    }
+
+    unflushed += batch.size();
+    batch.clear();
+  }
+
+  // flush periodically (or when shutting down) rather than per message
+  if (unflushed && (shutting_down.load() || (unflushed >= FLUSH_BYTES) ||
+                    (since_flush > FLUSH_INTERVAL))) {
+    if (out.has_value()) out->flush();
+
+    unflushed = 0;
+    since_flush.reset();
   }
 }
 
 bool Logger::should_log(csv mod, csv cat) noexcept { // static
   // in .cpp to avoid pulling config.hpp into Logger
-  return cfg_info(mod, cat);
+  //
+  // the [info] table is compiled into a LogFilter when config is ready (and
+  // each time it changes) so checking a category is a hash lookup rather
+  // than three toml path walks under the config shared lock
+  static ConfigValue<LogFilter> filter(
+      []() {
+        auto info = shared::config->table_at("info"sv).as_table();
+        return info ? LogFilter(*info) : LogFilter();
+      },
+      LogFilter());
+
+  return filter().should_log(mod, cat);
 }
 
 void Logger::shutdown_impl() noexcept {
@@ -72,6 +148,8 @@ void Logger::startup_impl() noexcept {
 
     const auto now = std::chrono::system_clock::now();
     out->print("\n{:%FT%H:%M:%S} START\n", now);
+
+    drain_timer_start();
   });
 
   auto latch = std::make_shared<std::latch>(1);
@@ -0,0 +1,103 @@
+//  Pierre - Custom Light Show for Wiss Landing
+//  Copyright (C) 2022  Tim Hughey
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//  https://www.wisslanding.com
+
+#include "lcs/metrics_server.hpp"
+#include "lcs/logger.hpp"
+
+#include <array>
+#include <fmt/format.h>
+
+namespace pierre {
+
+MetricsServer::MetricsServer(io_context &io_ctx, uint16_t port) noexcept
+    : io_ctx(io_ctx), acceptor(io_ctx) {
+  const tcp_endpoint ep(asio::ip::address_v4::loopback(), port);
+
+  // localhost only, metrics are not meant to leave the box
+  error_code ec;
+  acceptor.open(ep.protocol(), ec);
+  if (!ec) acceptor.set_option(tcp_acceptor::reuse_address(true), ec);
+  if (!ec) acceptor.bind(ep, ec);
+  if (!ec) acceptor.listen(socket_base::max_listen_connections, ec);
+
+  INFO_INIT("sizeof={:>4} localhost:{} {}\n", sizeof(MetricsServer), port, ec.message());
+
+  if (!ec) async_accept();
+}
+
+void MetricsServer::async_accept() noexcept {
+  acceptor.async_accept([this](const error_code ec, tcp_socket sock) {
+    if (ec) return; // shutdown
+
+    session(std::make_shared<tcp_socket>(std::move(sock)));
+    async_accept();
+  });
+}
+
+void MetricsServer::session(std::shared_ptr<tcp_socket> sock) noexcept {
+  static constexpr csv fn_id{"session"};
+
+  auto buf = std::make_shared<asio::streambuf>(4096); // request headers are small
+  auto deadline = std::make_shared<steady_timer>(io_ctx, SESSION_TIMEOUT);
+
+  // closing the socket completes the pending read or write (with an error)
+  deadline->async_wait([sock](const error_code ec) {
+    if (ec) return; // canceled, session completed
+
+    INFO_AUTO("timeout, closing\n");
+
+    error_code ignored;
+    sock->close(ignored);
+  });
+
+  asio::async_read_until(
+      *sock, *buf, "\r\n\r\n", [this, sock, buf, deadline](const error_code ec, size_t n) {
+        if (ec) {
+          deadline->cancel();
+          return;
+        }
+
+        const csv req(static_cast<const char *>(buf->data().data()), n);
+        const auto ok = req.starts_with("GET /metrics ") || req.starts_with("GET / ");
+
+        // the snapshot is shared with the write so update() may replace it meanwhile
+        auto body = ok ? snapshot : std::make_shared<const string>("not found\n");
+        auto head = std::make_shared<const string>(fmt::format(
+            "HTTP/1.1 {}\r\n"
+            "Content-Type: {}\r\n"
+            "Content-Length: {}\r\n"
+            "Connection: close\r\n\r\n",
+            ok ? "200 OK" : "404 Not Found",
+            ok ? "application/openmetrics-text; version=1.0.0; charset=utf-8" : "text/plain",
+            body->size()));
+
+        const std::array buffers{asio::buffer(*head), asio::buffer(*body)};
+
+        asio::async_write(*sock, buffers,
+                          [sock, head, body, deadline](const error_code ec, size_t) {
+                            if (ec) INFO_AUTO("write failed, {}\n", ec.message());
+
+                            deadline->cancel();
+
+                            error_code ignored;
+                            sock->shutdown(tcp_socket::shutdown_both, ignored);
+                          });
+      });
+}
+
+} // namespace pierre
@@ -17,21 +17,58 @@
 //  https://www.wisslanding.com
 
 #include "lcs/stats.hpp"
+#include "base/thread_util.hpp"
 #include "lcs/config.hpp"
+#include "lcs/logger.hpp"
 
+#include <algorithm>
 #include <fmt/format.h>
+#include <limits>
 #include <memory>
+#include <mutex>
 
 namespace pierre {
 
+namespace {
+// timing stats that also export their distribution each interval
+constexpr std::array timing_stats{
+    stats::DATA_MSG_WRITE_ELAPSED, stats::DECODE_ELAPSED,  stats::NEXT_FRAME_WAIT,
+    stats::PIPELINE_LATENCY,       stats::REMOTE_ROUNDTRIP, stats::RENDER_ELAPSED,
+    stats::RENDER_LATENESS,        stats::SYNC_WAIT,
+};
+
+std::array<Histogram, timing_stats.size()> timing_histograms;
+
+// levels (not events or timings), OpenMetrics exports their current value
+constexpr std::array gauge_stats{
+    stats::CLOCK_DRIFT,        stats::CLOCK_OFFSET,       stats::DMX_CONNECTED,
+    stats::DSP_QUEUE_DEPTH,    stats::FPS,                stats::MAX_PEAK_FREQUENCY,
+    stats::MAX_PEAK_MAGNITUDE, stats::PIPELINE_DEPTH,     stats::RACKED_FRAMES,
+    stats::REMOTE_DMX_QOK,     stats::REMOTE_DMX_QRF,     stats::REMOTE_DMX_QSF,
+};
+
+constexpr bool is_gauge(size_t vt) noexcept {
+  return std::find(gauge_stats.begin(), gauge_stats.end(), vt) != gauge_stats.end();
+}
+} // namespace
+
 // class static data
-std::shared_ptr<Stats> Stats::self;
+std::unique_ptr<Stats> Stats::self;
+std::atomic_bool Stats::enabled{false};
+std::atomic<uint32_t> Stats::epoch{1};
+std::array<std::atomic<stats::kind_t>, stats::STATS_V_MAX> Stats::kinds{};
+std::array<Stats::tag_entry, stats::slab::TAGS> Stats::tags{};
+std::array<Histogram *, stats::STATS_V_MAX> Stats::histograms{};
+std::atomic<uint64_t> Stats::dropped{0};
 
-Stats::Stats(io_context &io_ctx, bool enabled) noexcept
-    : io_ctx(io_ctx),   //
-      enabled(enabled), //
+Stats::Stats(Millis interval) noexcept
+    : export_timer(io_ctx), //
+      interval(interval),   //
       val_txt{
           // create map of stats val to text
+          {stats::CLOCK_DRIFT, "clock_drift"},
+          {stats::CLOCK_OFFSET, "clock_offset"},
+          {stats::CLOCK_RESIDUAL, "clock_residual"},
           {stats::CTRL_CONNECT_ELAPSED, "ctrl_connect_elapsed"},
           {stats::CTRL_CONNECT_TIMEOUT, "ctrl_connect_timeout"},
           {stats::CTRL_MSG_READ_ELAPSED, "ctrl_msg_read_elapsed"},
@@ -42,18 +79,24 @@ Stats::Stats(io_context &io_ctx, bool enabled) noexcept
           {stats::DATA_CONNECT_FAILED, "data_connect_failed"},
           {stats::DATA_MSG_WRITE_ELAPSED, "data_msg_write_elapsed"},
           {stats::DATA_MSG_WRITE_ERROR, "data_msg_write_error"},
+          {stats::DECODE_ELAPSED, "decode_elapsed"},
+          {stats::DMX_CONNECTED, "dmx_connected"},
+          {stats::DSP_QUEUE_DEPTH, "dsp_queue_depth"},
+          {stats::DSP_SILENCE, "dsp_silence"},
           {stats::FLUSH_ELAPSED, "flush_elapsed"},
           {stats::FPS, "fps"},
           {stats::FRAME, "frame"},
+          {stats::FRAME_POOL_HEAP, "frame_pool_heap"},
+          {stats::FRAMES_FLUSHED, "frames_flushed"},
           {stats::MAX_PEAK_FREQUENCY, "max_peak_frequency"},
           {stats::MAX_PEAK_MAGNITUDE, "max_peak_magnitude"},
           {stats::NEXT_FRAME_WAIT, "next_frame_wait"},
           {stats::NO_CONN, "no_conn"},
-          {stats::RACK_COLLISION, "rack_collision"},
-          {stats::RACK_WIP_INCOMPLETE, "rack_wip_incomplete"},
-          {stats::RACK_WIP_TIMEOUT, "rack_wip_timeout"},
-          {stats::RACKED_REELS, "racked_reels"},
-          {stats::REELS_FLUSHED, "reels_flushed"},
+          {stats::PIPELINE_DEPTH, "pipeline_depth"},
+          {stats::PIPELINE_DROPPED, "pipeline_dropped"},
+          {stats::PIPELINE_LATENCY, "pipeline_latency"},
+          {stats::RACK_DROPPED, "rack_dropped"},
+          {stats::RACKED_FRAMES, "racked_frames"},
           {stats::REMOTE_DATA_WAIT, "remote_data_wait"},
           {stats::REMOTE_DMX_QOK, "remote_dmx_qok"},
           {stats::REMOTE_DMX_QRF, "remote_dmx_qrf"},
@@ -61,43 +104,342 @@ Stats::Stats(io_context &io_ctx, bool enabled) noexcept
           {stats::REMOTE_ELAPSED, "remote_elapsed"},
           {stats::REMOTE_ROUNDTRIP, "remote_roundtrip"},
           {stats::RENDER_ELAPSED, "render_elapsed"},
+          {stats::RENDER_LATENESS, "render_lateness"},
           {stats::RTSP_AUDIO_CIPHERED, "rtsp_audio_ciphered"},
           {stats::RTSP_AUDIO_DECIPERED, "rtsp_audio_deciphered"},
           {stats::RTSP_SESSION_CONNECT, "rtsp_session_connect"},
           {stats::RTSP_SESSION_MSG_ELAPSED, "rtsp_session_msg_elapsed"},
           {stats::RTSP_SESSION_RX_PACKET, "rtsp_session_rx_packet"},
           {stats::RTSP_SESSION_TX_REPLY, "rtsp_session_tx_reply"},
+          {stats::STATS_DROPPED, "stats_dropped"},
           {stats::SYNC_WAIT, "sync_wait"},
           // comment allows for easy IDE sorting
       } //
 {}
 
-const string Stats::init(io_context &io_ctx) noexcept {
+Stats::~Stats() noexcept {
+  // export what has accumulated then stop, thread (declared last) joins first
+  if (thread.joinable()) {
+    asio::post(io_ctx, [this]() {
+      export_timer.cancel();
+      export_interval();
+      io_ctx.stop();
+    });
+  }
+}
+
+int Stats::claim_tag(std::pair<const char *, const char *> tag) noexcept { // static
+  static std::mutex mtx;
+  std::unique_lock lck(mtx);
+
+  // another thread may have claimed the tag (or the next free slot) since
+  // tag_slot() looked, so look again while holding the lock
+  for (size_t i = 1; i < stats::slab::TAGS; i++) {
+    auto &t = tags[i];
+
+    if (auto *key = t.key.load(std::memory_order_relaxed); key == nullptr) {
+      t.val.store(tag.second, std::memory_order_relaxed);
+      t.key.store(tag.first, std::memory_order_release); // publishes val
+      return i;
+    } else if ((key == tag.first) && (t.val.load(std::memory_order_relaxed) == tag.second)) {
+      return i;
+    }
+  }
+
+  return -1;
+}
+
+void Stats::export_interval() noexcept {
+  auto &r = registry();
+  const auto slabs = r.size();
+  const auto e = epoch.load(std::memory_order_relaxed);
+
+  prev.resize(slabs);
+
+  // combine the per thread accumulators (cumulative) into this interval
+  interval_table agg{};
+
+  for (size_t i = 0; i < slabs; i++) {
+    const auto &slab = r[i];
+
+    for (size_t vt = 0; vt < stats::STATS_V_MAX; vt++) {
+      for (size_t t = 0; t < stats::slab::TAGS; t++) {
+        const auto &c = slab.cells[vt][t];
+        auto &p = prev[i][vt][t];
+
+        const auto count = c.count.load(std::memory_order_acquire);
+        if (count == p.count) continue;
+
+        const auto sum = c.sum.load(std::memory_order_relaxed);
+        auto &a = agg[vt][t];
+
+        a.count += count - p.count;
+        a.sum += sum - p.sum;
+
+        // a gauge usually has one writer, otherwise any writer this interval
+        gauges[vt][t] = c.last.load(std::memory_order_relaxed);
+
+        // min/max are only meaningful when written during this interval
+        if (c.epoch.load(std::memory_order_relaxed) == e) {
+          a.min = std::min(a.min, c.min.load(std::memory_order_relaxed));
+          a.max = std::max(a.max, c.max.load(std::memory_order_relaxed));
+        }
+
+        p = stats::totals{count, sum};
+      }
+    }
+  }
+
+  // writers begin a new interval (min/max) with their next sample
+  epoch.store(e + 1, std::memory_order_relaxed);
+
+  if (const auto d = dropped.load(std::memory_order_relaxed); d != dropped_prev) {
+    const auto n = static_cast<double>(d - dropped_prev);
+
+    kinds[stats::STATS_DROPPED].store(stats::INTEGRAL, std::memory_order_relaxed);
+    agg[stats::STATS_DROPPED][0] = interval_t{1, n, n, n};
+    dropped_prev = d;
+  }
+
+  // running totals (since start) for the OpenMetrics counters
+  for (size_t vt = 0; vt < stats::STATS_V_MAX; vt++) {
+    for (size_t t = 0; t < stats::slab::TAGS; t++) {
+      cumulative[vt][t].count += agg[vt][t].count;
+      cumulative[vt][t].sum += agg[vt][t].sum;
+    }
+  }
+
+  histogram_table hsum{};
+  for (size_t vt = 0; vt < stats::STATS_V_MAX; vt++) {
+    if (auto *h = histograms[vt]; h) hsum[vt] = h->take();
+
+    // scrapes see the most recent interval that had samples
+    if (hsum[vt].count > 0) hsum_last[vt] = hsum[vt];
+  }
+
+  if (db) influx_write(agg, hsum);
+  if (metrics) metrics->update(openmetrics(hsum_last));
+}
+
+void Stats::influx_write(const interval_table &agg, const histogram_table &hsum) noexcept {
+  static constexpr csv COUNT{"count"};
+  static constexpr csv HISTOGRAM{"histogram"};
+  static constexpr csv MAX{"max"};
+  static constexpr csv MEASURE{"STATS"};
+  static constexpr csv METRIC{"metric"};
+  static constexpr csv MIN{"min"};
+  static constexpr csv NEGATIVE{"negative"};
+  static constexpr csv P50{"p50"};
+  static constexpr csv P90{"p90"};
+  static constexpr csv P99{"p99"};
+  static constexpr csv P999{"p999"};
+  static constexpr csv VIEW{"view"};
+  static constexpr std::array<csv, 4> FIELD{"", "nanos", "integral", "double"};
+
+  // one point per stat (and tag) per interval, written as a single batch
+  std::vector<influxdb::Point> points;
+
+  for (size_t vt = 0; vt < stats::STATS_V_MAX; vt++) {
+    const auto kind = kinds[vt].load(std::memory_order_relaxed);
+    const auto &vtxt = val_txt[static_cast<stats::stats_v>(vt)];
+
+    for (size_t t = 0; t < stats::slab::TAGS; t++) {
+      const auto &a = agg[vt][t];
+      if (a.count == 0) continue;
+
+      auto pt = influxdb::Point(MEASURE.data()).addTag(METRIC.data(), vtxt.data());
+
+      if (t > 0) {
+        pt.addTag(tags[t].key.load(std::memory_order_acquire),
+                  tags[t].val.load(std::memory_order_relaxed));
+      }
+
+      const auto mean = a.sum / a.count;
+      const bool have_min_max = a.min <= a.max;
+
+      // keep the field data type fixed per key (influx design)
+      if (kind == stats::DOUBLE) {
+        pt.addField(FIELD[kind], mean);
+        if (have_min_max) pt.addField(MIN, a.min).addField(MAX, a.max);
+      } else {
+        pt.addField(FIELD[kind], static_cast<int64_t>(std::llround(mean)));
+
+        if (have_min_max) {
+          pt.addField(MIN, static_cast<int64_t>(a.min)).addField(MAX, static_cast<int64_t>(a.max));
+        }
+      }
+
+      pt.addField(COUNT, static_cast<int64_t>(a.count));
+
+      points.emplace_back(std::move(pt));
+    }
+
+    // timing distributions, one point per histogram (untagged)
+    if (const auto &hs = hsum[vt]; hs.count > 0) {
+      auto pt = influxdb::Point(MEASURE.data()).addTag(METRIC.data(), vtxt.data());
+
+      pt.addTag(VIEW, HISTOGRAM)
+          .addField(P50, static_cast<int64_t>(hs.p50))
+          .addField(P90, static_cast<int64_t>(hs.p90))
+          .addField(P99, static_cast<int64_t>(hs.p99))
+          .addField(P999, static_cast<int64_t>(hs.p999))
+          .addField(MAX, static_cast<int64_t>(hs.max))
+          .addField(COUNT, static_cast<int64_t>(hs.count))
+          .addField(NEGATIVE, static_cast<int64_t>(hs.negative));
+
+      points.emplace_back(std::move(pt));
+    }
+  }
+
+  if (const auto count = std::ssize(points); count) {
+    try {
+      db->write(std::move(points));
+    } catch (const std::exception &e) {
+      static constexpr csv fn_id{"export"};
+      INFO_AUTO("write failed, points={} reason={}\n", count, e.what());
+    }
+  }
+}
+
+string Stats::openmetrics(const histogram_table &hsum) noexcept {
+  static constexpr std::array<csv, 4> UNIT{"", "_nanoseconds", "", ""};
+
+  string text;
+  auto w = std::back_inserter(text);
+
+  for (size_t vt = 0; vt < stats::STATS_V_MAX; vt++) {
+    const auto kind = kinds[vt].load(std::memory_order_relaxed);
+    if (kind == stats::UNSET) continue; // never written
+
+    const auto name = fmt::format("pierre_{}{}", val_txt[static_cast<stats::stats_v>(vt)],
+                                  UNIT[kind]);
+
+    auto labels = [](size_t t) {
+      if (t == 0) return string();
+
+      return fmt::format("{{{}=\"{}\"}}", tags[t].key.load(std::memory_order_acquire),
+                         tags[t].val.load(std::memory_order_relaxed));
+    };
+
+    // a gauge family: the most recent value per tag
+    if (is_gauge(vt)) {
+      fmt::format_to(w, "# TYPE {} gauge\n", name);
+
+      for (size_t t = 0; t < stats::slab::TAGS; t++) {
+        if (cumulative[vt][t].count) fmt::format_to(w, "{}{} {}\n", name, labels(t), gauges[vt][t]);
+      }
+
+      continue;
+    }
+
+    // a summary family: running sum and count per tag plus, for timing
+    // stats, the quantiles of the most recent interval
+    fmt::format_to(w, "# TYPE {} summary\n", name);
+
+    if (const auto &hs = hsum[vt]; hs.count > 0) {
+      const std::array<std::pair<csv, uint64_t>, 4> quantiles{
+          {{"0.5", hs.p50}, {"0.9", hs.p90}, {"0.99", hs.p99}, {"0.999", hs.p999}}};
+
+      for (const auto &[q, v] : quantiles) {
+        fmt::format_to(w, "{}{{quantile=\"{}\"}} {}\n", name, q, v);
+      }
+    }
+
+    for (size_t t = 0; t < stats::slab::TAGS; t++) {
+      const auto &c = cumulative[vt][t];
+      if (c.count == 0) continue;
+
+      fmt::format_to(w, "{}_sum{} {}\n", name, labels(t), c.sum);
+      fmt::format_to(w, "{}_count{} {}\n", name, labels(t), c.count);
+    }
+  }
+
+  // values sampled here (not written by the hot path)
+  fmt::format_to(w, "# TYPE pierre_config info\n");
+  fmt::format_to(w, "pierre_config_info{{vsn=\"{}\"}} 1\n", Config::ready() ? Config::vsn() : "");
+
+  text.append("# EOF\n");
+
+  return text;
+}
+
+void Stats::export_timer_start() noexcept {
+  export_timer.expires_after(interval);
+  export_timer.async_wait([this](const error_code ec) {
+    if (ec) return; // canceled (shutdown)
+
+    export_interval();
+    export_timer_start();
+  });
+}
+
+const string Stats::init() noexcept {
   string msg;
   auto w = std::back_inserter(msg);
 
-  fmt::format_to(w, "sizeof={:>4} ", sizeof(Stats));
+  fmt::format_to(w, "sizeof={:>4} slab={} ", sizeof(Stats), sizeof(stats::slab));
 
-  if (self.use_count() < 1) {
+  if (!self) {
     const auto db_uri = config_val("stats.db_uri", string());
-    auto enabled = config_val("stats.enabled", false);
+    const auto enable = config_val("stats.enabled", false);
+    const Millis interval(config_val("stats.interval_ms", 1000));
+    const auto metrics_enable = config_val("stats.metrics.enable", false);
+    const uint16_t metrics_port = config_val("stats.metrics.port", 9464);
 
-    self = std::shared_ptr<Stats>(new Stats(io_ctx, enabled));
-
-    if (db_uri.size() && enabled) {
+    self = std::unique_ptr<Stats>(new Stats(interval));
 
+    if (db_uri.size() && enable) {
       self->db = influxdb::InfluxDBFactory::Get(db_uri);
+      fmt::format_to(w, "db_uri={} ", db_uri);
+    }
 
-      if (std::size_t bs = config_val("stats.batch_of", 0); bs > 0) {
-        self->db->batchOf(bs);
+    // when disabled there is no listener and no snapshot is built
+    if (metrics_enable) {
+      self->metrics = std::make_unique<MetricsServer>(self->io_ctx, metrics_port);
+      fmt::format_to(w, "metrics_port={} ", metrics_port);
+    }
+
+    if (self->db || self->metrics) {
+      for (size_t i = 0; i < timing_stats.size(); i++) {
+        histograms[timing_stats[i]] = &timing_histograms[i];
       }
 
-      fmt::format_to(w, "db_uri={} ", db_uri);
+      // exporter runs on a dedicated thread, writers never touch io_ctx
+      self->export_timer_start();
+      self->thread = std::jthread([s = self.get()]() {
+        thread_util::set_name(module_id);
+        s->io_ctx.run();
+      });
+
+      enabled.store(true, std::memory_order_release); // publishes histograms
+
+      fmt::format_to(w, "interval={} ", interval);
     }
-    fmt::format_to(w, "enabled={}", enabled);
+
+    fmt::format_to(w, "enabled={}", enabled.load());
   }
 
   return msg;
 }
 
+Stats::slab_registry::lease Stats::register_slab() noexcept { // static
+  // a reused slab keeps its cumulative counts and sums, the exporter sees the
+  // new thread's writes as more of the same (no fold, nothing is lost).  an
+  // empty lease (too many threads alive) drops this thread's writes
+  return registry().acquire([](stats::slab &, size_t, bool) {});
+}
+
+Stats::slab_registry &Stats::registry() noexcept { // static
+  // independent of the Stats instance, a slab may be written until its
+  // thread exits
+  static slab_registry r;
+
+  return r;
+}
+
+void Stats::shutdown() noexcept { // static
+  enabled.store(false);
+  self.reset();
+}
+
 } // namespace pierre
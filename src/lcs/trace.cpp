@@ -0,0 +1,159 @@
+//  Pierre - Custom Light Show for Wiss Landing
+//  Copyright (C) 2022  Tim Hughey
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//  https://www.wisslanding.com
+
+#include "lcs/trace.hpp"
+#include "base/thread_util.hpp"
+#include "lcs/config.hpp"
+#include "lcs/logger.hpp"
+
+#include <fmt/format.h>
+#include <fmt/os.h>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace pierre {
+
+namespace {
+// set by init()
+Millis window{5000};
+string path;
+
+constexpr std::array<csv, trace::STAGE_MAX> stage_names{
+    "packet_read", "decipher", "decode", "fft_left", "fft_right", "fft_stereo",
+    "peaks",       "racked",   "dequeued", "rendered", "dmx_write"};
+} // namespace
+
+// class static data
+std::atomic_bool Trace::active{false};
+
+const string Trace::dump() noexcept {
+  static constexpr csv fn_id{"dump"};
+
+  if (!enabled()) return string("disabled");
+
+  auto &r = registry();
+  const auto since = (pet::now_monotonic() - window).count();
+
+  // rings do not change hands (first, thread_name) while dumping
+  std::unique_lock lck(r.mutex());
+  const auto rings = r.size();
+
+  string json;
+  auto w = std::back_inserter(json);
+
+  fmt::format_to(w, "{{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+
+  auto first = true;
+  auto sep = [&]() { return std::exchange(first, false) ? "" : ",\n"; };
+
+  for (size_t tid = 0; tid < rings; tid++) {
+    const auto &ring = r[tid];
+
+    fmt::format_to(w, "{}{{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":{}," //
+                   "\"args\":{{\"name\":\"{}\"}}}}",
+                   sep(), tid, ring.thread_name);
+
+    // events older than head - CAPACITY have been overwritten, those near that
+    // boundary may be overwritten while reading so they are checked again below
+    const auto head = ring.head.load(std::memory_order_acquire);
+    const auto oldest =
+        std::max(ring.first, head > trace::ring::CAPACITY ? head - trace::ring::CAPACITY : 0);
+
+    std::vector<std::array<int64_t, 3>> events;
+    events.reserve(head - oldest);
+
+    for (auto i = oldest; i < head; i++) {
+      const auto &e = ring.events[i & trace::ring::MASK];
+
+      events.push_back({e.ts.load(std::memory_order_relaxed), e.dur.load(std::memory_order_relaxed),
+                        static_cast<int64_t>(e.meta.load(std::memory_order_relaxed))});
+    }
+
+    const auto head_now = ring.head.load(std::memory_order_acquire);
+    const auto valid_from = head_now > trace::ring::CAPACITY ? head_now - trace::ring::CAPACITY : 0;
+
+    for (auto i = std::max(oldest, valid_from); i < head; i++) {
+      const auto &[ts, dur, meta] = events[i - oldest];
+      if (ts < since) continue;
+
+      const auto stage = static_cast<size_t>(meta & 0xff);
+      if (stage >= trace::STAGE_MAX) continue;
+
+      // chrome trace timestamps are (fractional) microseconds
+      if (dur > 0) {
+        fmt::format_to(w,
+                       "{}{{\"name\":\"{}\",\"cat\":\"frame\",\"ph\":\"X\",\"pid\":1,\"tid\":{},"
+                       "\"ts\":{:.3f},\"dur\":{:.3f},\"args\":{{\"seq_num\":{}}}}}",
+                       sep(), stage_names[stage], tid, ts / 1000.0, dur / 1000.0, meta >> 8);
+      } else {
+        fmt::format_to(w,
+                       "{}{{\"name\":\"{}\",\"cat\":\"frame\",\"ph\":\"i\",\"s\":\"t\",\"pid\":1,"
+                       "\"tid\":{},\"ts\":{:.3f},\"args\":{{\"seq_num\":{}}}}}",
+                       sep(), stage_names[stage], tid, ts / 1000.0, meta >> 8);
+      }
+    }
+  }
+
+  lck.unlock();
+
+  fmt::format_to(w, "\n]}}\n");
+
+  try {
+    const auto flags = fmt::file::WRONLY | fmt::file::CREATE | fmt::file::TRUNC;
+    auto out = fmt::output_file(path.c_str(), flags);
+    out.print("{}", json);
+  } catch (const std::exception &e) {
+    INFO_AUTO("write failed, path={} reason={}\n", path, e.what());
+    return string(e.what());
+  }
+
+  INFO_AUTO("path={} bytes={} threads={}\n", path, json.size(), rings);
+
+  return path;
+}
+
+void Trace::init() noexcept {
+  window = Millis(config_val("trace.window_ms", 5000));
+  path = config_val("trace.path", string("/tmp/pierre-trace.json"));
+
+  active.store(config_val("trace.enable", false));
+
+  INFO_INIT("sizeof={:>4} enabled={} window={} path={}\n", sizeof(trace::ring), enabled(),
+            window, path);
+}
+
+Trace::ring_registry::lease Trace::register_ring() noexcept { // static
+  // an empty lease (too many threads alive) leaves this thread untraced
+  return registry().acquire([](trace::ring &ring, size_t n, bool) {
+    // a reused ring starts after the previous thread's events, dump() skips
+    // them rather than show them under this thread's name
+    ring.first = ring.head.load(std::memory_order_relaxed);
+    ring.thread_name = thread_util::name().empty() ? fmt::format("thread{}", n)
+                                                   : string(thread_util::name());
+  });
+}
+
+Trace::ring_registry &Trace::registry() noexcept { // static
+  // independent of any instance, a thread may trace until it exits
+  static ring_registry r;
+
+  return r;
+}
+
+} // namespace pierre
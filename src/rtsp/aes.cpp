@@ -55,6 +55,17 @@ Aes::Aes() : cipher_ctx{nullptr}, result{nullptr}, setup_ctx{nullptr}, verify_ct
   }
 }
 
+Aes::Aes(const uint8v &shared_secret) : Aes() {
+  cipher_ctx = pair_cipher_new(HOMEKIT, 2, shared_secret.data(), shared_secret.size());
+
+  if (cipher_ctx == nullptr) {
+    static constexpr csv msg{"pair_cipher_new() failed"};
+    throw(std::runtime_error(msg.data()));
+  }
+
+  decrypt_in = true;
+}
+
 Aes::~Aes() {
   pair_cipher_free(cipher_ctx);
   pair_setup_free(setup_ctx);
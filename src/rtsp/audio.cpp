@@ -20,9 +20,11 @@
 #include "base/types.hpp"
 #include "desk/desk.hpp"
 #include "frame/frame.hpp"
+#include "frame/pipeline.hpp"
 #include "frame/racked.hpp"
 #include "lcs/config.hpp"
 #include "lcs/logger.hpp"
+#include "rtsp/capture.hpp"
 
 #include <ranges>
 #include <vector>
@@ -51,48 +53,67 @@ void Audio::async_read_packet() noexcept {
 
   packet_len.clear();
 
-  // start by reading the packet length
+  // start by reading the packet length (handlers run on the ingest thread
+  // so only one read is ever active)
   asio::async_read(                             // async read the length of the packet
       sock,                                     // read from socket
       asio::dynamic_buffer(packet_len),         // into this buffer
       asio::transfer_exactly(PACKET_LEN_BYTES), // fill the entire buffer
-      asio::bind_executor(                      // serialize so only one read is active
-          local_strand,                         // of the local stand
-          [this](error_code ec, ssize_t bytes) {
-            const auto msg = io::is_ready(sock, ec);
+      [this](error_code ec, ssize_t bytes) {
+        const auto msg = io::is_ready(sock, ec);
 
-            if (!msg.empty() || (bytes < std::ssize(packet_len))) {
-              INFO(module_id, fn_id, "bytes={} {}\n", bytes, msg);
-              return;
-            }
+        if (!msg.empty() || (bytes < std::ssize(packet_len))) {
+          INFO(module_id, fn_id, "bytes={} {}\n", bytes, msg);
+          return;
+        }
 
-            packet.clear();
+        packet.clear();
 
-            uint16_t len{0};
-            len += packet_len[0] << 8;
-            len += packet_len[1];
+        uint16_t len{0};
+        len += packet_len[0] << 8;
+        len += packet_len[1];
 
-            if (len > 2) len -= sizeof(len);
+        if (len > 2) len -= sizeof(len);
 
-            auto s = shared_from_this();
+        auto s = shared_from_this();
 
-            asio::async_read(                 //
-                sock,                         //
-                asio::dynamic_buffer(packet), //
-                asio::transfer_exactly(len),
-                asio::bind_executor(local_strand, [=, s = s](error_code ec, ssize_t bytes) {
-                  const auto msg = io::is_ready(s->sock, ec);
+        asio::async_read(                 //
+            sock,                         //
+            asio::dynamic_buffer(packet), //
+            asio::transfer_exactly(len), [=, s = s](error_code ec, ssize_t bytes) {
+              const auto msg = io::is_ready(s->sock, ec);
 
-                  if (!msg.empty() || (bytes != len)) {
-                    INFO(module_id, fn_id, "bytes={} msg\n", bytes, msg);
-                    return;
-                  }
+              if (!msg.empty() || (bytes != len)) {
+                INFO(module_id, fn_id, "bytes={} msg\n", bytes, msg);
+                return;
+              }
 
-                  s->rtsp_ctx->desk->handoff(std::move(s->packet), s->rtsp_ctx->shared_key);
+              auto key = s->rtsp_ctx->shared_key();
 
-                  if (s->sock.is_open()) s->async_read_packet();
-                }));
-          }));
+              Capture::packet(s->packet, *key);
+              s->rtsp_ctx->desk->handoff(std::move(s->packet), std::move(key));
+
+              if (s->sock.is_open()) s->async_read_packet();
+            });
+      });
+}
+
+void Audio::run() noexcept {
+  pipeline::stage_thread_init("ingest", -1); // name, pin (frame.pipeline.cpu.ingest)
+
+  io_ctx.run(); // returns once teardown closes the acceptor and socket
+
+  INFO(module_id, "thread", "ingest stopped\n");
+}
+
+void Audio::teardown() noexcept {
+  // the acceptor and socket belong to the ingest thread
+  asio::post(io_ctx, [s = shared_from_this()]() {
+    [[maybe_unused]] error_code ec;
+
+    s->acceptor.close(ec);
+    s->sock.close(ec);
+  });
 }
 
 } // namespace rtsp
@@ -0,0 +1,286 @@
+//  Pierre - Custom Light Show for Wiss Landing
+//  Copyright (C) 2022  Tim Hughey
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//  https://www.wisslanding.com
+
+#include "rtsp/capture.hpp"
+#include "lcs/config.hpp"
+#include "lcs/logger.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <fmt/format.h>
+#include <iterator>
+#include <limits>
+#include <mutex>
+
+namespace pierre {
+namespace rtsp {
+
+// resolved once and refreshed when the config file changes (read per packet)
+static ConfigValue<bool> cfg_enable(config_path<Capture>("enable"), false);
+static ConfigValue<string> cfg_file(config_path<Capture>("file"), "/tmp/pierre-audio.cap");
+
+namespace {
+constexpr size_t RECORD_HEADER_BYTES{sizeof(uint8_t) + sizeof(uint64_t) + sizeof(uint16_t)};
+
+// the open capture, records arrive from the audio strand and rtsp threads
+struct writer {
+  std::mutex mtx;
+  std::FILE *file{nullptr};
+  Nanos start{0};
+  uint8v key; // last key recorded
+};
+
+writer &capture_writer() noexcept {
+  static writer w;
+
+  return w;
+}
+
+void put(uint8v &buff, uint64_t val, size_t bytes) noexcept {
+  for (size_t i = bytes; i > 0; i--) {
+    buff.push_back((val >> ((i - 1) * 8)) & 0xff);
+  }
+}
+
+uint64_t get(const uint8v &buff, size_t &pos, size_t bytes) noexcept {
+  uint64_t val{0};
+
+  for (size_t i = 0; (i < bytes) && (pos < buff.size()); i++) {
+    val = (val << 8) | buff[pos++];
+  }
+
+  return val;
+}
+
+// caller holds the writer mutex
+void write_record(writer &w, capture::record_t type, const uint8_t *data, size_t len) noexcept {
+  static constexpr csv fn_id{"write"};
+
+  if (!w.file) {
+    const auto path = cfg_file();
+
+    w.file = std::fopen(path.c_str(), "wb");
+    if (!w.file) {
+      INFO(Capture::module_id, fn_id, "failed to open file={}\n", path);
+      return;
+    }
+
+    w.start = pet::now_monotonic();
+    w.key.clear();
+
+    uint8v header;
+    header.assign(capture::MAGIC.begin(), capture::MAGIC.end());
+    put(header, w.start.count(), sizeof(uint64_t));
+
+    std::fwrite(header.data(), 1, header.size(), w.file);
+
+    INFO(Capture::module_id, fn_id, "started file={}\n", path);
+  }
+
+  if (len > std::numeric_limits<uint16_t>::max()) return; // never from the socket
+
+  uint8v header(RECORD_HEADER_BYTES);
+  put(header, type, sizeof(uint8_t));
+  put(header, pet::elapsed(w.start).count(), sizeof(uint64_t));
+  put(header, len, sizeof(uint16_t));
+
+  std::fwrite(header.data(), 1, header.size(), w.file);
+  std::fwrite(data, 1, len, w.file);
+}
+
+void record(capture::record_t type, const uint8v &payload) noexcept {
+  auto &w = capture_writer();
+  std::unique_lock lck(w.mtx);
+
+  write_record(w, type, payload.data(), payload.size());
+}
+
+} // namespace
+
+// payload encoding
+uint8v capture::clock_sample_t::encode() const noexcept {
+  uint8v buff(sizeof(uint64_t) * 3);
+
+  put(buff, clock_id, sizeof(uint64_t));
+  put(buff, sample_time, sizeof(uint64_t));
+  put(buff, raw_offset, sizeof(uint64_t));
+
+  return buff;
+}
+
+capture::clock_sample_t capture::clock_sample_t::decode(const uint8v &payload) noexcept {
+  size_t pos{0};
+  clock_sample_t clock;
+
+  clock.clock_id = get(payload, pos, sizeof(uint64_t));
+  clock.sample_time = get(payload, pos, sizeof(uint64_t));
+  clock.raw_offset = get(payload, pos, sizeof(uint64_t));
+
+  return clock;
+}
+
+uint8v capture::anchor_t::encode() const noexcept {
+  uint8v buff(sizeof(uint8_t) + sizeof(uint64_t) * 5);
+
+  // bit 0: complete, bit 1: rate present, bit 2: rate
+  const uint8_t bits = (complete ? 0x01 : 0x00) |            //
+                       (rate.has_value() ? 0x02 : 0x00) |     //
+                       (rate.value_or(false) ? 0x04 : 0x00); //
+
+  put(buff, bits, sizeof(uint8_t));
+  put(buff, clock_id, sizeof(uint64_t));
+  put(buff, secs, sizeof(uint64_t));
+  put(buff, fracs, sizeof(uint64_t));
+  put(buff, rtp_time, sizeof(uint64_t));
+  put(buff, flags, sizeof(uint64_t));
+
+  return buff;
+}
+
+capture::anchor_t capture::anchor_t::decode(const uint8v &payload) noexcept {
+  size_t pos{0};
+  anchor_t anchor;
+
+  const auto bits = get(payload, pos, sizeof(uint8_t));
+  anchor.complete = bits & 0x01;
+  if (bits & 0x02) anchor.rate.emplace(bits & 0x04);
+
+  anchor.clock_id = get(payload, pos, sizeof(uint64_t));
+  anchor.secs = get(payload, pos, sizeof(uint64_t));
+  anchor.fracs = get(payload, pos, sizeof(uint64_t));
+  anchor.rtp_time = get(payload, pos, sizeof(uint64_t));
+  anchor.flags = get(payload, pos, sizeof(uint64_t));
+
+  return anchor;
+}
+
+uint8v capture::flush_t::encode() const noexcept {
+  uint8v buff(sizeof(uint32_t) * 4);
+
+  put(buff, info.from_seq, sizeof(uint32_t));
+  put(buff, info.from_ts, sizeof(uint32_t));
+  put(buff, info.until_seq, sizeof(uint32_t));
+  put(buff, info.until_ts, sizeof(uint32_t));
+
+  return buff;
+}
+
+capture::flush_t capture::flush_t::decode(const uint8v &payload) noexcept {
+  size_t pos{0};
+
+  const seq_num_t from_seq = get(payload, pos, sizeof(uint32_t));
+  const timestamp_t from_ts = get(payload, pos, sizeof(uint32_t));
+  const seq_num_t until_seq = get(payload, pos, sizeof(uint32_t));
+  const timestamp_t until_ts = get(payload, pos, sizeof(uint32_t));
+
+  return flush_t{.info = FlushInfo(from_seq, from_ts, until_seq, until_ts)};
+}
+
+// Capture API
+bool Capture::enabled() noexcept { return cfg_enable(); } // static
+
+void Capture::packet(const uint8v &packet, const uint8v &key) noexcept { // static
+  if (!cfg_enable()) return;
+
+  auto &w = capture_writer();
+  std::unique_lock lck(w.mtx);
+
+  if (key != w.key || !w.file) {
+    write_record(w, capture::KEY, key.data(), key.size());
+    w.key = key;
+  }
+
+  write_record(w, capture::PACKET, packet.data(), packet.size());
+}
+
+void Capture::clock(const ClockInfo &clock) noexcept { // static
+  if (!cfg_enable()) return;
+
+  record(capture::CLOCK,
+         capture::clock_sample_t{clock.clock_id, clock.sampleTime, clock.rawOffset}.encode());
+}
+
+void Capture::anchor(const capture::anchor_t &anchor) noexcept { // static
+  if (cfg_enable()) record(capture::ANCHOR, anchor.encode());
+}
+
+void Capture::flush(const FlushInfo &info) noexcept { // static
+  if (cfg_enable()) record(capture::FLUSH, capture::flush_t{.info = info}.encode());
+}
+
+void Capture::teardown(bool disconnect) noexcept { // static
+  static constexpr csv fn_id{"teardown"};
+  if (!cfg_enable()) return;
+
+  auto &w = capture_writer();
+  std::unique_lock lck(w.mtx);
+
+  const uint8_t val = disconnect ? 1 : 0;
+  write_record(w, capture::TEARDOWN, &val, sizeof(val));
+
+  if (disconnect && w.file) {
+    std::fclose(w.file);
+    w.file = nullptr;
+
+    INFO_AUTO("closed, duration={}\n", pet::humanize(pet::elapsed(w.start)));
+  }
+}
+
+capture::records Capture::load(const string &path, Nanos &start, string &err) noexcept {
+  capture::records records;
+
+  auto *file = std::fopen(path.c_str(), "rb");
+  if (!file) {
+    err = fmt::format("unable to open {}", path);
+    return records;
+  }
+
+  auto read = [file](uint8v &buff, size_t bytes) {
+    buff.assign(bytes, 0x00);
+    return std::fread(buff.data(), 1, bytes, file) == bytes;
+  };
+
+  uint8v buff;
+  if (!read(buff, capture::MAGIC.size() + sizeof(uint64_t)) ||
+      !std::equal(capture::MAGIC.begin(), capture::MAGIC.end(), buff.begin())) {
+    err = fmt::format("{} is not a capture file", path);
+  } else {
+    size_t pos{capture::MAGIC.size()};
+    start = Nanos(get(buff, pos, sizeof(uint64_t)));
+  }
+
+  while (err.empty() && read(buff, RECORD_HEADER_BYTES)) {
+    size_t pos{0};
+
+    auto &rec = records.emplace_back();
+    rec.type = static_cast<capture::record_t>(get(buff, pos, sizeof(uint8_t)));
+    rec.at = Nanos(get(buff, pos, sizeof(uint64_t)));
+
+    if (!read(rec.payload, get(buff, pos, sizeof(uint16_t)))) {
+      records.pop_back();
+      err = fmt::format("{} truncated after {} records", path, records.size());
+    }
+  }
+
+  std::fclose(file);
+
+  return records;
+}
+
+} // namespace rtsp
+} // namespace pierre
@@ -120,7 +120,7 @@ Port Ctx::server_port(ports_t server_type) noexcept {
   switch (server_type) {
 
   case ports_t::AudioPort:
-    audio_srv = Audio::start(io_ctx, shared_from_this());
+    audio_srv = Audio::start(shared_from_this());
     port = audio_srv->port();
     break;
 
@@ -22,6 +22,7 @@
 #include "frame/anchor_data.hpp"
 #include "lcs/logger.hpp"
 #include "replies/dict_kv.hpp"
+#include "rtsp/capture.hpp"
 
 namespace pierre {
 namespace rtsp {
@@ -33,14 +34,24 @@ SetAnchor::SetAnchor(const uint8v &content_in, Reply &reply, Desk *desk) noexcep
   static const Aplist::KeyList keys{NET_TIMELINE_ID, NET_TIME_SECS, NET_TIME_FRAC, NET_TIME_FLAGS,
                                     RTP_TIME};
 
+  capture::anchor_t captured;
+
   if (request_dict.existsAll(keys)) {
     // this is a complete anchor data set
-    Anchor::save(                                        // submit the new anchor data
-        AnchorData(request_dict.uint({NET_TIMELINE_ID}), // network timeline id (aka source clk)
-                   request_dict.uint({NET_TIME_SECS}),   // source clock seconds
-                   request_dict.uint({NET_TIME_FRAC}),   // source clock fractional nanos
-                   request_dict.uint({RTP_TIME}),        // rtp time (as defined by source),
-                   request_dict.uint({NET_TIME_FLAGS})   // flags (from source)
+    captured = capture::anchor_t{.complete = true,
+                                 .clock_id = request_dict.uint({NET_TIMELINE_ID}),
+                                 .secs = request_dict.uint({NET_TIME_SECS}),
+                                 .fracs = request_dict.uint({NET_TIME_FRAC}),
+                                 .rtp_time = request_dict.uint({RTP_TIME}),
+                                 .flags = request_dict.uint({NET_TIME_FLAGS}),
+                                 .rate = std::nullopt};
+
+    Anchor::save(                         // submit the new anchor data
+        AnchorData(captured.clock_id,     // network timeline id (aka source clk)
+                   captured.secs,         // source clock seconds
+                   captured.fracs,        // source clock fractional nanos
+                   captured.rtp_time,     // rtp time (as defined by source),
+                   captured.flags         // flags (from source)
                    ));
   } else {
     Anchor::reset();
@@ -49,11 +60,14 @@ SetAnchor::SetAnchor(const uint8v &content_in, Reply &reply, Desk *desk) noexcep
   if (request_dict.exists(RATE)) {
     // note: rate is misleading, it is actually the flag that controls playback
     bool rate = request_dict.uint({RATE});
+    captured.rate.emplace(rate);
     desk->spool(rate);
   } else {
     INFO(module_id, "NOTICE", "rate not present\n");
   }
 
+  Capture::anchor(captured);
+
   reply(RespCode::OK);
 }
 
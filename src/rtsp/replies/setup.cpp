@@ -19,6 +19,7 @@
 #include "replies/setup.hpp"
 #include "base/host.hpp"
 #include "ctx.hpp"
+#include "desk/desk.hpp"
 #include "frame/master_clock.hpp"
 #include "lcs/config.hpp"
 #include "lcs/logger.hpp"
@@ -125,7 +126,7 @@ bool Setup::has_streams() noexcept {
 
     ctx->active_remote = headers_in.val<int64_t>(hdr_type::DacpActiveRemote);
     ctx->dacp_id = headers_in.val(hdr_type::DacpID);
-    ctx->shared_key = s0.dataArray({SHK}); // copy is ok here
+    ctx->shared_key(s0.dataArray({SHK})); // copy is ok here
 
     auto stream_type = ctx->setup_stream_type(s0.uint({TYPE}));
 
@@ -142,6 +143,7 @@ bool Setup::has_streams() noexcept {
                               {BUFF_SIZE, buff_size}});                       // our buffer size
 
       ctx->set_live();
+      ctx->desk->audio_format(stream_info.ct); // decoder matches the stream
 
     } else if (stream_info.is_realtime()) {
       rc = false;
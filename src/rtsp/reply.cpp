@@ -26,6 +26,7 @@
 #include "mdns/mdns.hpp"
 #include "rtsp/aes.hpp"
 #include "rtsp/aplist.hpp"
+#include "rtsp/capture.hpp"
 #include "rtsp/ctx.hpp"
 #include "rtsp/replies/command.hpp"
 #include "rtsp/replies/dict_kv.hpp"
@@ -160,6 +161,7 @@ void Reply::build(std::shared_ptr<Ctx> ctx, const Headers &headers_in,
     ctx_naked->master_clock->peers(peer_list);
 
   } else if (method == csv("SETRATEANCHORTIME")) {
+    Capture::clock(ctx_naked->master_clock->snapshot());
     SetAnchor(content_in, *this, ctx->desk);
   } else if (method == csv("TEARDOWN")) {
 
@@ -170,9 +172,11 @@ void Reply::build(std::shared_ptr<Ctx> ctx, const Headers &headers_in,
 
     // any TEARDOWN request (with streams key or not) always clears the shared key and
     // informs Racked spooling should be stopped
-    ctx_naked->shared_key.clear();
+    ctx_naked->shared_key(uint8v());
     ctx->desk->spool(false);
 
+    Capture::teardown(request_dict.exists(STREAMS) == false);
+
     // when the streams key is not present this is a complete disconnect
     if (request_dict.exists(STREAMS) == false) {
       mDNS::service().receiver_active(false);
@@ -188,12 +192,13 @@ void Reply::build(std::shared_ptr<Ctx> ctx, const Headers &headers_in,
     // notes:
     // 1. from_seq and from_ts may not be present
     // 2. until_seq and until_ts should always be present
-    ctx_naked->desk->flush(                             //
-        FlushInfo(request_dict.uint({FLUSH_FROM_SEQ}),  //
-                  request_dict.uint({FLUSH_FROM_TS}),   //
-                  request_dict.uint({FLUSH_UNTIL_SEQ}), //
-                  request_dict.uint({FLUSH_UNTIL_TS}))  //
-    );
+    FlushInfo flush_info(request_dict.uint({FLUSH_FROM_SEQ}),  //
+                         request_dict.uint({FLUSH_FROM_TS}),   //
+                         request_dict.uint({FLUSH_UNTIL_SEQ}), //
+                         request_dict.uint({FLUSH_UNTIL_TS})); //
+
+    Capture::flush(flush_info);
+    ctx_naked->desk->flush(std::move(flush_info));
 
     set_resp_code(RespCode::OK);
 
@@ -26,14 +26,14 @@
 namespace pierre {
 namespace rtsp {
 
+// resolved once and refreshed when the config file changes (read per message)
+static ConfigValue<bool> cfg_enable(config_path<Saver>("enable"), false);
+static ConfigValue<string> cfg_file(config_path<Saver>("file"), "/tmp/rtsp.log");
+
 Saver::Saver(Saver::Direction direction, const Headers &headers, const uint8v &content,
-             const RespCode resp_code) noexcept
-    : enable(config_val2<Saver, bool>("enable", false)),         //
-      file{config_val2<Saver, string>("file", "/tmp/rtsp.log")}, //
-      format(config_val2<Saver, string>("format", "raw"))        //
-{
+             const RespCode resp_code) noexcept {
   static constexpr csv separator{"\r\n"};
-  if (!enable) return;
+  if (!cfg_enable()) return;
 
   uint8v buff;
   auto w = std::back_inserter(buff);
@@ -61,7 +61,7 @@ Saver::Saver(Saver::Direction direction, const Headers &headers, const uint8v &c
 
   try {
     auto mode = fmt::file::WRONLY | fmt::file::CREATE | fmt::file::APPEND;
-    auto out = fmt::output_file(file.c_str(), mode);
+    auto out = fmt::output_file(cfg_file().c_str(), mode);
 
     if (direction == Saver::IN) {
       out.print("{} {} RTSP/1.0{}{}", headers.method(), headers.path(), separator, buff.view());
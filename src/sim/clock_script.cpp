@@ -0,0 +1,129 @@
+//  Pierre - Custom Light Show for Wiss Landing
+//  Copyright (C) 2022  Tim Hughey
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//  https://www.wisslanding.com
+
+#include "sim/clock_script.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <fmt/format.h>
+#include <stdexcept>
+#include <string>
+
+namespace pierre {
+namespace sim {
+
+ClockScript::ClockScript() noexcept {
+  clock_event event;
+  event.clock_id = CLOCK_ID;
+  event.master_for = Seconds(10);
+  event.offset = 0;
+
+  add(std::move(event));
+}
+
+ClockScript::ClockScript(const toml::table &table) {
+  _interval = Millis(table["interval_ms"sv].value_or<int64_t>(122));
+
+  const auto *list = table["event"sv].as_array();
+  if (!list) return;
+
+  for (const auto &node : *list) {
+    const auto *ev = node.as_table();
+    if (!ev) throw std::runtime_error("event must be a table");
+
+    const auto &t = *ev;
+    clock_event event;
+    event.at = Millis(t["at_ms"sv].value_or<int64_t>(0));
+
+    if (auto id = t["clock_id"sv].value<string>(); id.has_value()) {
+      event.clock_id = std::stoull(*id, nullptr, 0);
+    } else if (auto id = t["clock_id"sv].value<int64_t>(); id.has_value()) {
+      event.clock_id = *id;
+    }
+
+    if (event.clock_id.has_value() && (*event.clock_id == 0)) {
+      throw std::runtime_error(fmt::format("event at_ms={} clock_id must not be zero",
+                                           pet::as<Millis>(event.at).count()));
+    }
+
+    event.master_for = Millis(t["master_for_ms"sv].value_or<int64_t>(0));
+    event.offset = t["offset_ns"sv].value<int64_t>();
+    event.step = t["step_ns"sv].value<int64_t>();
+    event.drift_ppm = t["drift_ppm"sv].value<double>();
+    event.stale = Millis(t["stale_ms"sv].value_or<int64_t>(0));
+
+    add(std::move(event));
+  }
+}
+
+ClockScript &ClockScript::add(clock_event event) noexcept {
+  auto it = std::upper_bound(events.begin(), events.end(), event.at,
+                             [](Nanos at, const clock_event &e) { return at < e.at; });
+
+  events.insert(it, std::move(event));
+
+  return *this;
+}
+
+clock_sample ClockScript::sample(Nanos at) const noexcept {
+  clock_sample sample;
+
+  double offset{0};
+  double drift{0}; // ns per ns
+  Nanos offset_at{0};
+  Nanos stale_until{0};
+
+  // offset drifts linearly between events
+  auto advance = [&](Nanos to) {
+    offset += drift * (to - offset_at).count();
+    offset_at = to;
+  };
+
+  for (const auto &e : events) {
+    if (e.at > at) break;
+
+    advance(e.at);
+
+    if (e.clock_id.has_value()) {
+      sample.clock_id = *e.clock_id;
+      sample.master_start = e.at - e.master_for;
+    }
+
+    if (e.offset.has_value()) offset = *e.offset;
+    if (e.step.has_value()) offset += *e.step;
+    if (e.drift_ppm.has_value()) drift = *e.drift_ppm / 1'000'000.0;
+    if (e.stale > Nanos::zero()) stale_until = e.at + e.stale;
+  }
+
+  advance(at);
+
+  sample.offset = static_cast<uint64_t>(std::llround(offset));
+  sample.stale = at < stale_until;
+
+  return sample;
+}
+
+ClockInfo ClockScript::clock_info(Nanos at, Nanos start) const noexcept {
+  const auto s = sample(at);
+
+  return ClockInfo(s.clock_id, "127.0.0.1", (start + at).count(), s.offset,
+                   start + s.master_start);
+}
+
+} // namespace sim
+} // namespace pierre
@@ -0,0 +1,90 @@
+//  Pierre - Custom Light Show for Wiss Landing
+//  Copyright (C) 2022  Tim Hughey
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//  https://www.wisslanding.com
+
+#include "sim/nqptp.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <fmt/format.h>
+#include <pthread.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace pierre {
+namespace sim {
+
+Nqptp::Nqptp(const string &shm_name) : shm_name(shm_name) {
+  constexpr auto bytes = sizeof(MasterClock::nqptp);
+
+  auto shm_fd = shm_open(shm_name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+
+  if (shm_fd < 0) {
+    throw std::runtime_error(
+        fmt::format("shm_open({}) failed: {}", shm_name, std::strerror(errno)));
+  }
+
+  void *mapped{MAP_FAILED};
+  if (ftruncate(shm_fd, bytes) == 0) {
+    mapped = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, shm_fd, 0);
+  }
+
+  close(shm_fd); // done with the shm memory fd
+
+  if (mapped == MAP_FAILED) {
+    shm_unlink(shm_name.c_str());
+    throw std::runtime_error(fmt::format("mmap({}) failed: {}", shm_name, std::strerror(errno)));
+  }
+
+  data = static_cast<MasterClock::nqptp *>(mapped);
+
+  // the mutex is shared with the reader (MasterClock) in another process
+  pthread_mutexattr_t attr;
+  pthread_mutexattr_init(&attr);
+  pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+  pthread_mutex_init(&data->copy_mutes, &attr);
+  pthread_mutexattr_destroy(&attr);
+
+  data->version = MasterClock::NQPTP_VERSION;
+}
+
+Nqptp::~Nqptp() noexcept {
+  munmap(data, sizeof(MasterClock::nqptp));
+  shm_unlink(shm_name.c_str());
+}
+
+void Nqptp::publish(ClockID clock_id, Nanos local_time, uint64_t offset,
+                    Nanos master_start) noexcept {
+  static constexpr csv ip{"127.0.0.1"};
+
+  pthread_mutex_lock(&data->copy_mutes);
+
+  data->master_clock_id = clock_id;
+  std::fill(std::begin(data->master_clock_ip), std::end(data->master_clock_ip), '\0');
+  std::copy(ip.begin(), ip.end(), std::begin(data->master_clock_ip));
+  data->local_time = local_time.count();
+  data->local_to_master_time_offset = offset;
+  data->master_clock_start_time = master_start.count();
+
+  pthread_mutex_unlock(&data->copy_mutes);
+}
+
+} // namespace sim
+} // namespace pierre
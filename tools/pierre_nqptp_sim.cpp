@@ -0,0 +1,134 @@
+//  Pierre - Custom Light Show for Wiss Landing
+//  Copyright (C) 2022  Tim Hughey
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//  https://www.wisslanding.com
+
+// stand-in for nqptp: publishes a scripted master clock (see sim/clock_script.hpp)
+// to a shm segment in the nqptp layout so pierre runs without nqptp or PTP peers
+//
+// usage: pierre_nqptp_sim [--shm=<name>] [--script=<file>] [--duration-s=<n>]
+//
+// pierre reads the segment named by master_clock.shm_name.  without a script
+// the clock is stable and never changes.  runs until the script duration (or
+// SIGINT), the segment is removed on exit.
+
+#include "base/pet.hpp"
+#include "base/types.hpp"
+#include "sim/clock_script.hpp"
+#include "sim/nqptp.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <exception>
+#include <fmt/format.h>
+#include <optional>
+#include <thread>
+
+using namespace pierre;
+
+namespace {
+std::atomic_bool running{true};
+
+struct options {
+  string shm_name{"/pierre-sim"};
+  string script;
+  Seconds duration{0}; // zero == until SIGINT
+};
+
+options parse_args(int argc, char *argv[]) {
+  options opts;
+
+  for (int i = 1; i < argc; i++) {
+    const csv arg{argv[i]};
+    const auto val = [&arg](csv key) { return arg.substr(key.size()); };
+
+    if (arg.starts_with("--shm=")) {
+      opts.shm_name = val("--shm=");
+    } else if (arg.starts_with("--script=")) {
+      opts.script = val("--script=");
+    } else if (arg.starts_with("--duration-s=")) {
+      opts.duration = Seconds(std::strtoull(val("--duration-s=").data(), nullptr, 10));
+    } else {
+      fmt::print(stderr, "unknown argument: {}\n", arg);
+      fmt::print(stderr, "usage: pierre_nqptp_sim [--shm=<name>] [--script=<file>] "
+                         "[--duration-s=<n>]\n");
+      std::exit(1);
+    }
+  }
+
+  return opts;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  const auto opts = parse_args(argc, argv);
+
+  std::optional<sim::ClockScript> script;
+  std::optional<sim::Nqptp> nqptp;
+
+  try {
+    script.emplace(opts.script.empty() ? sim::ClockScript()
+                                       : sim::ClockScript(toml::parse_file(opts.script)));
+    nqptp.emplace(opts.shm_name);
+  } catch (const toml::parse_error &err) {
+    fmt::print(stderr, "{}: {}\n", opts.script, err.description());
+    return 1;
+  } catch (const std::exception &err) {
+    fmt::print(stderr, "{}\n", err.what());
+    return 1;
+  }
+
+  std::signal(SIGINT, [](int) { running = false; });
+  std::signal(SIGTERM, [](int) { running = false; });
+
+  fmt::print("publishing shm={} interval={}\n", opts.shm_name,
+             pet::humanize(script->interval()));
+
+  const auto start = pet::now_monotonic();
+  auto next = std::chrono::steady_clock::now();
+  sim::clock_sample last;
+
+  while (running) {
+    const auto now = pet::now_monotonic();
+    const auto at = now - start;
+
+    if ((opts.duration > Seconds::zero()) && (at >= opts.duration)) break;
+
+    const auto s = script->sample(at);
+
+    if (!s.stale) {
+      nqptp->publish(s.clock_id, now, s.offset, start + s.master_start);
+    }
+
+    // note the scripted changes as they happen
+    if ((s.clock_id != last.clock_id) || (s.stale != last.stale)) {
+      fmt::print("{:>10} clock_id={:#x} offset={} stale={}\n", pet::humanize(at), s.clock_id,
+                 s.offset, s.stale);
+    }
+
+    last = s;
+
+    next += script->interval();
+    std::this_thread::sleep_until(next);
+  }
+
+  fmt::print("stopped, removing shm={}\n", opts.shm_name);
+
+  return 0;
+}
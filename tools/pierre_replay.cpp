@@ -0,0 +1,317 @@
+//  Pierre - Custom Light Show for Wiss Landing
+//  Copyright (C) 2022  Tim Hughey
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//  https://www.wisslanding.com
+
+// replay an audio capture (see rtsp/capture.hpp) through Desk (Racked, Av, dsp,
+// FX and DmxCtrl) without an AirPlay sender
+//
+// usage: pierre_replay <capture> [--cfg-file=<file>] [--speed=<x>] [--tail-ms=<ms>]
+//
+// the master clock is simulated: a private nqptp segment (master_clock.shm_name,
+// must not be the segment of a running nqptp) is published with the captured
+// clock advancing at --speed.  records are handed to Desk at their capture
+// offset divided by --speed.
+//
+// at --speed=1 the replay matches the live session.  faster replays decipher,
+// decode and dsp every packet at the higher rate while Desk renders in real
+// time so the frames between renders are consumed as outdated.  MasterClock
+// samples the clock every master_clock.refresh_ms, lower it for fast replays.
+
+#include "base/crypto.hpp"
+#include "base/pet.hpp"
+#include "base/types.hpp"
+#include "base/uint8v.hpp"
+#include "desk/desk.hpp"
+#include "frame/anchor.hpp"
+#include "frame/anchor_data.hpp"
+#include "frame/master_clock.hpp"
+#include "io/io.hpp"
+#include "lcs/config.hpp"
+#include "lcs/logger.hpp"
+#include "lcs/stats.hpp"
+#include "lcs/trace.hpp"
+#include "rtsp/capture.hpp"
+#include "sim/nqptp.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdlib>
+#include <exception>
+#include <fmt/format.h>
+#include <memory>
+#include <optional>
+#include <thread>
+
+using namespace pierre;
+
+namespace {
+namespace capture = rtsp::capture;
+
+struct options {
+  string path;
+  string cfg_file{"live.toml"};
+  double speed{1.0};
+  Millis tail{3000}; // capture time after the last record (frames still racked)
+};
+
+options parse_args(int argc, char *argv[]) {
+  options opts;
+
+  for (int i = 1; i < argc; i++) {
+    const csv arg{argv[i]};
+    const auto val = [&arg](csv key) { return arg.substr(key.size()); };
+
+    if (arg.starts_with("--cfg-file=")) {
+      opts.cfg_file = val("--cfg-file=");
+    } else if (arg.starts_with("--speed=")) {
+      opts.speed = std::strtod(val("--speed=").data(), nullptr);
+    } else if (arg.starts_with("--tail-ms=")) {
+      opts.tail = Millis(std::strtoull(val("--tail-ms=").data(), nullptr, 10));
+    } else if (!arg.starts_with("--") && opts.path.empty()) {
+      opts.path = arg;
+    } else {
+      fmt::print(stderr, "unknown argument: {}\n", arg);
+      std::exit(1);
+    }
+  }
+
+  if (opts.path.empty() || (opts.speed <= 0.0)) {
+    fmt::print(stderr, "usage: pierre_replay <capture> [--cfg-file=<file>] [--speed=<x>] "
+                       "[--tail-ms=<ms>]\n");
+    std::exit(1);
+  }
+
+  return opts;
+}
+
+/// @brief The captured master clock replayed at speed.  Capture time (at) maps
+///        to replay time (now) by at = (now - start) * speed and the master
+///        clock at capture time is base + at.
+class Timeline {
+public:
+  Timeline(const string &shm_name, double speed) : nqptp(shm_name), speed(speed) {}
+
+  Nanos at(Nanos now = pet::now_monotonic()) const noexcept {
+    const auto started = start.load();
+    if (started == 0) return Nanos::zero();
+
+    return Nanos(static_cast<int64_t>((now.count() - started) * speed));
+  }
+
+  Nanos local(Nanos at) const noexcept {
+    return Nanos(start.load() + static_cast<int64_t>(at.count() / speed));
+  }
+
+  void begin() noexcept { start.store(pet::now_monotonic().count()); }
+
+  void master(ClockID id, Nanos base_at_zero) noexcept {
+    clock_id.store(id);
+    base.store(base_at_zero.count());
+  }
+
+  // nqptp publishes every ~122ms, faster replays publish more often so the
+  // offset (which grows with speed) stays close to the simulated clock
+  void publish() noexcept {
+    const auto now = pet::now_monotonic();
+    const uint64_t master = base.load() + at(now).count();
+
+    // mastership began well before the replay so the clock is stable
+    nqptp.publish(clock_id.load(), now, master - now.count(), now - Seconds(10));
+  }
+
+  Nanos publish_interval() const noexcept {
+    const Nanos interval(static_cast<int64_t>(Nanos(Millis(122)).count() / speed));
+
+    return std::max(Nanos(Millis(1)), interval);
+  }
+
+private:
+  sim::Nqptp nqptp;
+  const double speed;
+  std::atomic<int64_t> start{0};
+  std::atomic<ClockID> clock_id{0};
+  std::atomic<uint64_t> base{0};
+};
+
+/// @brief Master clock at capture time zero, from the first usable CLOCK record
+///        or (when the clock was not ready) assuming the first anchor arrived
+///        at its anchor time
+std::optional<std::pair<ClockID, Nanos>> captured_master(const capture::records &records,
+                                                         Nanos capture_start) noexcept {
+  for (const auto &rec : records) {
+    if (rec.type == capture::CLOCK) {
+      const auto clock = capture::clock_sample_t::decode(rec.payload);
+
+      if (clock.clock_id) {
+        return std::make_pair(clock.clock_id, pet::apply_offset(capture_start, clock.raw_offset));
+      }
+    } else if (rec.type == capture::ANCHOR) {
+      const auto anchor = capture::anchor_t::decode(rec.payload);
+
+      if (anchor.complete) {
+        const AnchorData ad(anchor.clock_id, anchor.secs, anchor.fracs, anchor.rtp_time,
+                            anchor.flags);
+        return std::make_pair(anchor.clock_id, ad.anchor_time - rec.at);
+      }
+    }
+  }
+
+  return std::nullopt;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  const auto opts = parse_args(argc, argv);
+
+  string err;
+  Nanos capture_start{0};
+  const auto records = rtsp::Capture::load(opts.path, capture_start, err);
+
+  if (!err.empty()) fmt::print(stderr, "{}\n", err);
+
+  const auto master = captured_master(records, capture_start);
+  if (!master) {
+    fmt::print(stderr, "{} has no clock or anchor, nothing to replay\n", opts.path);
+    return 1;
+  }
+
+  crypto::init();
+
+  io_context io_ctx;
+
+  toml::table cli_table;
+  cli_table.emplace("home"sv, string(std::getenv("HOME")));
+  cli_table.emplace("cfg-file"sv, opts.cfg_file);
+  cli_table.emplace("app_name"sv, string("pierre_replay"));
+
+  shared::config = std::make_unique<Config>(io_ctx, cli_table);
+  config()->init();
+
+  Logger::startup();
+  Stats::init();
+  Trace::init();
+
+  std::optional<Timeline> timeline;
+
+  try {
+    timeline.emplace(config_val2<MasterClock, string>("shm_name", "/nqptp"), opts.speed);
+  } catch (const std::exception &e) {
+    fmt::print(stderr, "{} (set master_clock.shm_name to a private segment)\n", e.what());
+    return 1;
+  }
+
+  timeline->master(master->first, master->second);
+  timeline->publish();
+
+  std::atomic_bool publishing{true};
+  std::jthread publisher([&]() {
+    while (publishing) {
+      std::this_thread::sleep_for(timeline->publish_interval());
+      timeline->publish();
+    }
+  });
+
+  // as in the app, Desk (and Racked, which creates Anchor) is running well
+  // before the first session
+  auto master_clock = std::make_unique<MasterClock>();
+  auto desk = std::make_unique<Desk>(master_clock.get());
+  std::this_thread::sleep_for(1s);
+
+  std::array<size_t, capture::TEARDOWN + 1> counts{0};
+  auto key = std::make_shared<const uint8v>(); // shared with the queued packets, as in Ctx
+
+  timeline->begin();
+
+  for (const auto &rec : records) {
+    const auto wait = timeline->local(rec.at) - pet::now_monotonic();
+    if (wait > Nanos::zero()) std::this_thread::sleep_for(wait);
+
+    if (rec.type <= capture::TEARDOWN) counts[rec.type]++;
+
+    switch (rec.type) {
+    case capture::PACKET: {
+      uint8v packet(rec.payload);
+      desk->handoff(std::move(packet), key);
+    } break;
+
+    case capture::KEY:
+      key = std::make_shared<const uint8v>(rec.payload);
+      break;
+
+    case capture::CLOCK: {
+      const auto clock = capture::clock_sample_t::decode(rec.payload);
+      if (clock.clock_id) {
+        timeline->master(clock.clock_id, pet::apply_offset(capture_start, clock.raw_offset));
+      }
+    } break;
+
+    case capture::ANCHOR: {
+      const auto anchor = capture::anchor_t::decode(rec.payload);
+
+      if (anchor.complete) {
+        Anchor::save(AnchorData(anchor.clock_id, anchor.secs, anchor.fracs, anchor.rtp_time,
+                                anchor.flags));
+      } else {
+        Anchor::reset();
+      }
+
+      if (anchor.rate.has_value()) desk->spool(*anchor.rate);
+    } break;
+
+    case capture::FLUSH:
+      desk->flush(capture::flush_t::decode(rec.payload).info);
+      break;
+
+    case capture::TEARDOWN:
+      key = std::make_shared<const uint8v>();
+      desk->spool(false);
+      if (rec.payload.size() && rec.payload[0]) desk->flush_all();
+      break;
+    }
+  }
+
+  // racked frames render for a while after the last packet arrived
+  const auto end_at = (records.empty() ? Nanos::zero() : records.back().at) + opts.tail;
+  const auto tail = timeline->local(end_at) - pet::now_monotonic();
+  if (tail > Nanos::zero()) std::this_thread::sleep_for(tail);
+
+  const auto replayed = pet::now_monotonic() - timeline->local(Nanos::zero());
+
+  fmt::print(stderr,
+             "replayed {} records in {} (capture {}, x{:.2f}) packets={} anchors={} "
+             "flushes={} teardowns={}\n",
+             records.size(), pet::humanize(replayed), pet::humanize(end_at),
+             static_cast<double>(end_at.count()) / replayed.count(), counts[capture::PACKET],
+             counts[capture::ANCHOR], counts[capture::FLUSH], counts[capture::TEARDOWN]);
+
+  if (Trace::enabled()) fmt::print(stderr, "trace {}\n", Trace::dump());
+
+  desk.reset();
+  master_clock.reset();
+
+  publishing = false;
+  publisher.join();
+  timeline.reset();
+
+  Stats::shutdown();
+  Logger::shutdown();
+  shared::config.reset();
+
+  return err.empty() ? 0 : 2;
+}